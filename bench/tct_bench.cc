@@ -0,0 +1,406 @@
+/**
+ * @brief Benchmarks of the simulation core
+ * @author D. Rosich
+ *
+ * Micro-benchmarks of the hot functions and macro-benchmarks of whole runs,
+ * written as json so two builds can be compared on numbers:
+ *
+ *   tct_bench [--quick] [--filter <text>] [--output <file.json>]
+ *             [--baseline <file.json>] [--tolerance <fraction>]
+ *
+ * Every benchmark reports the median time per iteration over several samples
+ * and a throughput (calls/s, carriers/s, samples/s, carrier-steps/s or
+ * pulses/s). With --baseline, each benchmark is compared with the one of the
+ * same name in a previous output and the program exits with status 1 if any
+ * throughput dropped by more than the tolerance (10% by default).
+ *
+ * Run it from a build directory next to exp_data, as tct_sim.
+ */
+
+#include "beam_profile.hh"
+#include "beam_template.hh"
+#include "charge_injection.hh"
+#include "detector.hh"
+#include "electronics.hh"
+#include "npy.hh"
+#include "pulse.hh"
+#include "simd.hh"
+#include "simulation_params.hh"
+#include "sweep.hh"
+#include "thread_pool.hh"
+#include "transport_engine.hh"
+#include "utility.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+/**
+ * @struct Bench_result
+ *
+ * timing of one benchmark
+ */
+struct Bench_result
+{
+    std::string name;
+    std::string kind;           // "micro" or "macro"
+    double seconds;             // median time per iteration (s)
+    double min_seconds;         // fastest iteration (s)
+    std::size_t iterations;     // iterations per sample
+    std::size_t samples;
+    double throughput;          // items per second at the median
+    std::string unit;
+};
+
+// results of the optimiser are written here so it cannot drop the work
+static volatile float sink;
+
+/**
+ * @brief time a benchmark
+ *
+ * calibrates the number of iterations so a sample lasts at least min_time,
+ * then takes the median of the samples
+ *
+ * @param name benchmark name
+ * @param kind "micro" or "macro"
+ * @param unit throughput unit
+ * @param items items processed by one iteration
+ * @param run one iteration
+ * @param min_time shortest sample (s)
+ * @param samples number of samples
+ */
+static Bench_result _measure(const std::string& name, const std::string& kind, const std::string& unit,
+                             double items, const std::function<void()>& run, double min_time, std::size_t samples)
+{
+    using clock = std::chrono::steady_clock;
+    auto time = [&run](std::size_t n)
+    {
+        auto start = clock::now();
+        for (std::size_t i = 0; i < n; ++i) run();
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    // warm-up, also the first estimate of the cost of an iteration
+    std::size_t n = 1;
+    double t = time(n);
+    while (t < min_time)
+    {
+        n = t > 0. ? std::max<std::size_t>(2*n, static_cast<std::size_t>(1.2*n*min_time/t)) : 2*n;
+        t = time(n);
+    }
+
+    std::vector<double> per_iteration;
+    for (std::size_t s = 0; s < samples; ++s) per_iteration.push_back(time(n)/n);
+    std::sort(per_iteration.begin(), per_iteration.end());
+
+    Bench_result r;
+    r.name = name;
+    r.kind = kind;
+    r.seconds = per_iteration[per_iteration.size()/2];
+    r.min_seconds = per_iteration.front();
+    r.iterations = n;
+    r.samples = samples;
+    r.throughput = items/r.seconds;
+    r.unit = unit;
+    std::cout << std::left << std::setw(36) << name << std::right << std::setw(14) << std::setprecision(4)
+              << r.seconds*1e6 << " us  " << std::setw(12) << r.throughput << " " << unit << std::endl;
+    return r;
+}
+
+/**
+ * @brief parameters of the benchmarks: the example configuration
+ */
+static Simulation_params _params(int N)
+{
+    json data = {
+        {"detector", {{"Nd", 1.7e20}, {"width", 50e-6}, {"length", 50e-6}, {"V_bi", 3.0},
+                      {"V_bias", 450.0}, {"R", 50.0}, {"material", "SiC"}}},
+        {"injection", {{"focus", 25e-6}, {"wavelength", 800e-9}, {"NA", 0.186},
+                       {"refractive_index", 2.76}, {"N", N}}},
+        {"simulation", {{"steps", 500}, {"dt", 0.005e-9}, {"t_pc", 0.25e-9}, {"type", "z_scan"},
+                        {"threads", 0}, {"seed", 12345}}}
+    };
+    return parse_simulation_params(data);
+}
+
+/**
+ * @brief carrier-steps of one pulse
+ *
+ * runs the stepped transport of simulate_pulse and adds up the carriers
+ * still drifting at every step
+ */
+static double _carrier_steps(const Simulation_params& par, Detector* det, Thread_pool* pool)
+{
+    Charge_injection injection_e(par.injection.focus, par.injection.wavelength, par.injection.NA,
+                                 par.injection.refractive_index, det, 0, par.injection.N,
+                                 derive_seed(par.simulation.seed, 0));
+    Charge_injection injection_h = injection_e;
+    injection_h.set_type(1);
+    Transport_engine engine(injection_e, injection_h, det, pool);
+    engine.set_diffusion(par.simulation.diffusion, derive_seed(par.simulation.seed, 0));
+    engine.set_trapping(par.simulation.trapping);
+    double total = 0.;
+    for (int step = 0; step < par.simulation.steps && !engine.is_done(); ++step)
+    {
+        total += injection_e.get_charges().size() + injection_h.get_charges().size();
+        engine.step(par.simulation.dt);
+    }
+    return total;
+}
+
+static void _micro(std::vector<Bench_result>& results, const std::string& filter, bool quick)
+{
+    double min_time = quick ? 0.02 : 0.2;
+    std::size_t samples = quick ? 3 : 7;
+    auto wanted = [&filter](const std::string& name) {return name.find(filter) != std::string::npos;};
+    Simulation_params par = _params(10000);
+    Detector det = make_detector(par.detector);
+
+    if (wanted("linear_field"))
+    {
+        const int n = 4096;
+        results.push_back(_measure("linear_field", "micro", "calls/s", n, [&det]() {
+            float s = 0.;
+            for (int i = 0; i < n; ++i) s += linear_field(0., i*50e-6f/n, &det);
+            sink = s;
+        }, min_time, samples));
+    }
+
+    if (wanted("linear_interpolation"))
+    {
+        std::vector<float> x(200), y(200);
+        for (int i = 0; i < 200; ++i) {x[i] = i*1e5f; y[i] = std::sqrt(i*1e5f);}
+        const int n = 4096;
+        results.push_back(_measure("linear_interpolation", "micro", "calls/s", n, [&x, &y]() {
+            float s = 0.;
+            for (int i = 0; i < n; ++i) s += linear_interpolation(i*(2e7f/n), x, y);
+            sink = s;
+        }, min_time, samples));
+    }
+
+    // _compute_xy_beam is private: the injection is timed through the
+    // constructor, which samples the beam and fills the carrier store
+    if (wanted("injection_sampling"))
+    {
+        int N = par.injection.N;
+        results.push_back(_measure("injection_sampling", "micro", "carriers/s", N, [&par, &det]() {
+            Charge_injection injection(par.injection.focus, par.injection.wavelength, par.injection.NA,
+                                       par.injection.refractive_index, &det, 0, par.injection.N, 1);
+            sink = injection.get_charges().size();
+        }, min_time, samples));
+    }
+
+    if (wanted("profile_sampling"))
+    {
+        // a 2D gaussian focus of 256 x 1024 cells, written once to a
+        // temporary .npy
+        const std::size_t n_r = 256, n_z = 1024;
+        Beam_profile_params bp{(std::filesystem::temp_directory_path() / "tct_bench_profile.npy").string(),
+                               -100e-6, 100e-6, 20e-6, false};
+        {
+            Npy_writer table(bp.file, n_z);
+            std::vector<float> row(n_z);
+            double w0 = par.injection.wavelength/(M_PI*par.injection.NA);
+            double b = par.injection.NA/par.injection.refractive_index;
+            for (std::size_t ir = 0; ir < n_r; ++ir)
+            {
+                double r = (ir + 0.5)*bp.r_max/n_r;
+                for (std::size_t iz = 0; iz < n_z; ++iz)
+                {
+                    double z = bp.z_min + (iz + 0.5)*(bp.z_max - bp.z_min)/n_z;
+                    double w2 = w0*w0 + b*b*z*z;
+                    row[iz] = std::exp(-2.*r*r/w2)/w2;
+                }
+                table.write_row(row.data());
+            }
+        }
+        Beam_profile profile(bp.file, bp, par.injection.wavelength, par.injection.NA, par.injection.refractive_index);
+        std::filesystem::remove(bp.file);
+        int N = par.injection.N;
+        results.push_back(_measure("profile_sampling", "micro", "carriers/s", N, [&profile, N]() {
+            Beam_template beam(profile, N, 1);
+            sink = beam.size();
+        }, min_time, samples));
+    }
+
+    if (wanted("update_speeds"))
+    {
+        Charge_injection injection(par.injection.focus, par.injection.wavelength, par.injection.NA,
+                                   par.injection.refractive_index, &det, 0, par.injection.N, 1);
+        double n = injection.get_charges().size();
+        results.push_back(_measure("update_speeds", "micro", "carriers/s", n, [&injection]() {
+            injection.update_speeds();
+            sink = injection.get_charges().vy()[0];
+        }, min_time, samples));
+    }
+
+    if (wanted("rc_filter") || wanted("shaper_filter"))
+    {
+        const std::size_t n = par.simulation.steps;
+        std::vector<float> signal(n), filtered(n);
+        for (std::size_t i = 0; i < n; ++i) signal[i] = std::exp(-0.01f*i);
+        if (wanted("rc_filter"))
+        {
+            Rc_response rc(par.simulation.dt, par.detector.R, par.detector.C);
+            results.push_back(_measure("rc_filter", "micro", "samples/s", n, [&]() {
+                rc.apply(signal.data(), filtered.data(), n);
+                sink = filtered[n - 1];
+            }, min_time, samples));
+        }
+        if (wanted("shaper_filter"))
+        {
+            Simulation_params shaped = par;
+            shaped.electronics.model = "shaper";
+            shaped.electronics.order = 2;
+            shaped.electronics.shaping_time = 0.2e-9;
+            auto response = electronics_response(shaped);
+            results.push_back(_measure("shaper_filter", "micro", "samples/s", n, [&]() {
+                response->apply(signal.data(), filtered.data(), n);
+                sink = filtered[n - 1];
+            }, min_time, samples));
+        }
+    }
+}
+
+static void _macro(std::vector<Bench_result>& results, const std::string& filter, bool quick, Thread_pool& pool)
+{
+    double min_time = quick ? 0. : 0.5;
+    std::size_t samples = quick ? 1 : 3;
+    auto wanted = [&filter](const std::string& name) {return name.find(filter) != std::string::npos;};
+    std::vector<int> pulse_sizes = quick ? std::vector<int>{1000} : std::vector<int>{1000, 10000, 100000};
+    std::vector<int> scan_sizes = quick ? std::vector<int>{1000} : std::vector<int>{1000, 10000};
+
+    for (int N : pulse_sizes)
+    {
+        std::string name = "visualization_pulse/N=" + std::to_string(N);
+        if (!wanted(name)) continue;
+        Simulation_params par = _params(N);
+        Detector det = make_detector(par.detector);
+        double steps = _carrier_steps(par, &det, &pool);
+        results.push_back(_measure(name, "macro", "carrier-steps/s", steps, [&]() {
+            Pulse pulse = simulate_pulse(par.injection.focus, par, &det, derive_seed(par.simulation.seed, 0), &pool);
+            sink = pulse.charge;
+        }, min_time, samples));
+    }
+
+    for (int N : scan_sizes)
+    {
+        std::string name = "z_scan/N=" + std::to_string(N);
+        if (!wanted(name)) continue;
+        Simulation_params par = _params(N);
+        std::size_t n_points = make_z_scan_points(par).size();
+        results.push_back(_measure(name, "macro", "pulses/s", n_points, [&]() {
+            std::vector<Sweep_point> points = make_z_scan_points(par);
+            run_sweep(points, pool);
+            sink = points.back().pulse.charge;
+        }, min_time, samples));
+    }
+}
+
+/**
+ * @brief compare with a baseline
+ *
+ * @returns number of regressions
+ */
+static int _compare(const std::vector<Bench_result>& results, const json& baseline, double tolerance)
+{
+    int regressions = 0;
+    std::cout << "\n=== Comparison with the baseline (tolerance " << tolerance*100 << "%)" << std::endl;
+    for (const Bench_result& r : results)
+    {
+        const json* old = nullptr;
+        for (const json& b : baseline.at("benchmarks"))
+            if (b.at("name") == r.name) old = &b;
+        std::cout << std::left << std::setw(36) << r.name << std::right;
+        if (!old)
+        {
+            std::cout << "  not in the baseline" << std::endl;
+            continue;
+        }
+        double ratio = r.throughput/old->at("throughput").get<double>();
+        bool regressed = ratio < 1. - tolerance;
+        regressions += regressed;
+        std::cout << std::setw(10) << std::setprecision(3) << ratio << "x"
+                  << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    std::string filter, output, baseline_path;
+    double tolerance = 0.10;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quick") quick = true;
+        else if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--output" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baseline_path = argv[++i];
+        else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::atof(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--filter <text>] [--output <file.json>]"
+                      << " [--baseline <file.json>] [--tolerance <fraction>]" << std::endl;
+            return 1;
+        }
+    }
+
+    json baseline;
+    if (!baseline_path.empty())
+    {
+        std::ifstream in(baseline_path);
+        if (!in.is_open()) {
+            std::cerr << "Could not open baseline " << baseline_path << std::endl;
+            return 1;
+        }
+        in >> baseline;
+    }
+
+    Thread_pool pool(0);
+    std::vector<Bench_result> results;
+    try {
+        _micro(results, filter, quick);
+        _macro(results, filter, quick, pool);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "benchmark failed: " << e.what() << std::endl;
+        return 2;
+    }
+
+    json report;
+    report["host"] = {{"compiler", __VERSION__}, {"simd_width", simd::Native::width},
+                      {"threads", pool.get_n_workers()},
+                      {"hardware_threads", std::thread::hardware_concurrency()}, {"quick", quick}};
+    report["benchmarks"] = json::array();
+    for (const Bench_result& r : results)
+        report["benchmarks"].push_back({{"name", r.name}, {"kind", r.kind}, {"seconds", r.seconds},
+                                        {"min_seconds", r.min_seconds}, {"iterations", r.iterations},
+                                        {"samples", r.samples}, {"throughput", r.throughput}, {"unit", r.unit}});
+    if (!output.empty())
+    {
+        std::ofstream out(output);
+        if (!out.is_open()) {
+            std::cerr << "Could not open output file " << output << std::endl;
+            return 2;
+        }
+        out << report.dump(4) << "\n";
+        std::cout << "=== Results written to " << output << std::endl;
+    }
+
+    if (!baseline_path.empty() && _compare(results, baseline, tolerance) > 0)
+        return 1;
+    return 0;
+}
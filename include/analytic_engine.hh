@@ -0,0 +1,42 @@
+#ifndef _ANALYTICENGINE_HH_
+#define _ANALYTICENGINE_HH_
+
+/**
+ * @class Analytic_engine
+ * @author D. Rosich
+ *
+ * Alternative to Transport_engine for fields that only depend on depth. Carriers only
+ * drift along y and v depends on y alone, so every carrier of a species
+ * follows the same trajectory shifted in time. The engine tabulates once the
+ * time needed to reach the collecting electrode from any depth, places each
+ * carrier on that curve and bins the induced current of the whole population
+ * on the simulation time grid, without stepping the carriers. It assumes the
+ * uniform weighting field of a pad electrode covering the whole sensor.
+ * Trapping does not depend on the trajectory, only on the time since the
+ * injection, so it scales each time bin.
+ */
+
+#include "charge_injection.hh"
+#include "detector.hh"
+
+#include <vector>
+
+class Analytic_engine
+{
+    public:
+        Analytic_engine(Charge_injection&, Charge_injection&, Detector*);
+        ~Analytic_engine() = default;
+
+        void run(float, int, std::vector<float>&, std::vector<float>&);
+        void set_trapping(bool);
+
+    private:
+        Charge_injection* _electrons;
+        Charge_injection* _holes;
+        Detector* _det;
+        bool _trapping;
+
+        std::vector<float> _species_current(Charge_injection&, int, float, int);
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _BATCH_HH_
+#define _BATCH_HH_
+
+/**
+ * @brief Headless execution
+ * @author D. Rosich
+ *
+ * Runs a configuration without any graphics and writes the results as csv
+ * files in an output directory:
+ *   - visualization: pulse.csv, the waveforms of one pulse at the focus
+ *   - z_scan: z_scan.csv, charge and WPC of the built-in z-scan
+ *   - sweep: the sweep table (sweeps.output)
+ * Builds with TCT_PROFILING also write profile.json, the time spent in each
+ * phase and the counters of the run (see profiler.hh), and on request a
+ * Chrome trace, trace.json.
+ * Meant for batch nodes: it never blocks and returns a process exit status.
+ */
+
+#include "simulation_params.hh"
+
+#include <string>
+
+int run_batch(const Simulation_params&, const std::string&, bool trace = false);
+
+#endif
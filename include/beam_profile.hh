@@ -0,0 +1,111 @@
+#ifndef _BEAMPROFILE_HH_
+#define _BEAMPROFILE_HH_
+
+/**
+ * @class Beam_profile
+ * @author D. Rosich
+ *
+ * TPA carrier density of a tabulated laser intensity, such as the focal
+ * volumes of optical_sim/z_scan_3D_vectorial.py exported by
+ * optical_sim/export_beam_profile.py. The table is a .npy file read through
+ * a memory map, either the on-axis intensity I(z) or an axisymmetric I(r, z)
+ * (shape n_r x n_z, z fastest), with each value standing for a cell of a
+ * regular grid over [0, r_max] x [z_min, z_max], z ascending along the beam
+ * and relative to the focus. The intensity is squared (two-photon absorption)
+ * and, as for the analytic beam, the carriers are those of the plane of the
+ * simulation through the beam axis: a cell of a 2D table holds I^2 dr dz on
+ * either side of the axis. An on-axis table takes a gaussian transverse
+ * profile whose width follows from the intensity at each depth (w^2 I
+ * constant, the waist given by the NA), so it integrates to I^2 w dz.
+ * In the axisymmetric geometry the carriers fill the 3D focal volume
+ * instead: a cell holds I^2 2 pi r dr dz (I^2 w^2 dz on axis) and the
+ * radius is drawn with its Jacobian, on a random side of the axis.
+ *
+ * The cell probabilities go into an alias table when the profile is built,
+ * so a carrier costs O(1) whatever the size of the table: one cell draw and
+ * a uniform position inside it. The profile is never modified after it is
+ * built and can be shared by concurrent scan points.
+ */
+
+#include "simulation_params.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+class Beam_profile
+{
+    public:
+        Beam_profile(const std::string&, const Beam_profile_params&, float, float, float, bool axisymmetric = false);
+        ~Beam_profile() = default;
+
+        /**
+         * @brief draw one carrier
+         *
+         * @param gen random generator
+         * @param x transverse position (m)
+         * @param u depth relative to the focus (m)
+         */
+        template <class Generator>
+        void sample(Generator& gen, float& x, float& u) const
+        {
+            std::uniform_real_distribution<float> unif01(0., 1.);
+            // double: a float leaves few bits for the fraction of a large table
+            double pick = std::uniform_real_distribution<double>(0., 1.)(gen)*_probability.size();
+            std::size_t cell = std::min(static_cast<std::size_t>(pick), _probability.size() - 1);
+            if (pick - cell >= _probability[cell]) cell = _alias[cell];
+
+            std::size_t ir = cell/_n_z;
+            std::size_t iz = cell%_n_z;
+            u = _z_min + (iz + unif01(gen))*_dz;
+            if (_n_r == 1)
+            {
+                std::normal_distribution<float> gauss(0., 1.);
+                x = gauss(gen);
+                if (_axisymmetric) x = std::copysign(std::hypot(x, gauss(gen)), x);
+                x *= _sigma[iz];
+                return;
+            }
+            float r;
+            if (_axisymmetric)
+            {
+                // uniform in the annulus: r^2 is uniform between its edges
+                float r0 = ir*_dr;
+                float r1 = r0 + _dr;
+                r = std::sqrt(r0*r0 + unif01(gen)*(r1*r1 - r0*r0));
+            }
+            else
+                r = (ir + unif01(gen))*_dr;
+            x = unif01(gen) < 0.5f ? -r : r;
+        }
+
+        inline std::size_t get_n_r() const {return _n_r;}
+        inline std::size_t get_n_z() const {return _n_z;}
+        inline float get_wavelength() const {return _wavelength;}
+        inline float get_NA() const {return _numerical_aperture;}
+        inline float get_refractive_index() const {return _refractive_index;}
+
+    private:
+        float _wavelength;
+        float _numerical_aperture;
+        float _refractive_index;
+        bool _axisymmetric;
+
+        std::size_t _n_r;
+        std::size_t _n_z;
+        float _z_min;
+        float _dz;
+        float _dr;
+        std::vector<float> _sigma;          // transverse sigma per depth of an on-axis table (m)
+        std::vector<float> _probability;    // alias table: keep the cell below this
+        std::vector<std::uint32_t> _alias;  // and take this one otherwise
+};
+
+std::shared_ptr<const Beam_profile> beam_profile(const Simulation_params&);
+
+#endif
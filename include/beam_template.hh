@@ -0,0 +1,58 @@
+#ifndef _BEAMTEMPLATE_HH_
+#define _BEAMTEMPLATE_HH_
+
+/**
+ * @class Beam_template
+ * @author D. Rosich
+ *
+ * Charge carriers of one TPA-TCT laser shot sampled once, in coordinates
+ * relative to the focus. For a fixed wavelength, NA and refractive index the
+ * carrier density only shifts with the focus, so every point of a z-scan can
+ * take its carriers from the same template: the samples are kept sorted by
+ * depth and a scan point reads the contiguous range that falls inside its
+ * window, translated by its focus. The template is never modified, so it can
+ * be shared by concurrent scan points. The carriers are drawn from the
+ * analytic gaussian beam or from a tabulated Beam_profile.
+ */
+
+#include "carrier_store.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+class Beam_profile;
+
+class Beam_template
+{
+    public:
+        Beam_template(float, float, float, int, std::uint64_t,
+                      float u_min = -std::numeric_limits<float>::infinity(),
+                      float u_max = std::numeric_limits<float>::infinity(),
+                      bool axisymmetric = false);
+        Beam_template(const Beam_profile&, int, std::uint64_t);
+        ~Beam_template() = default;
+
+        std::pair<std::size_t, std::size_t> range(float, float) const;
+
+        inline std::size_t size() const {return _x.size();}
+        inline const float* x() const {return _x.data();}
+        inline const float* u() const {return _u.data();}
+        inline float get_wavelength() const {return _wavelength;}
+        inline float get_NA() const {return _numerical_aperture;}
+        inline float get_refractive_index() const {return _refractive_index;}
+
+    private:
+        void _store(std::vector<std::pair<float, float>>&);
+
+        float _wavelength;
+        float _numerical_aperture;
+        float _refractive_index;
+
+        aligned_vector _x;  // transverse position (m)
+        aligned_vector _u;  // depth relative to the focus, ascending (m)
+};
+
+#endif
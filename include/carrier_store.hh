@@ -0,0 +1,87 @@
+#ifndef _CARRIERSTORE_HH_
+#define _CARRIERSTORE_HH_
+
+/**
+ * @class Carrier_store
+ * @author D. Rosich
+ *
+ * Structure-of-arrays container for a population of charge carriers of a
+ * single type. Positions, drift velocities and weights are stored in
+ * separate contiguous, 64-byte aligned arrays so the transport kernels can
+ * stream through them with vector loads. Every carrier also keeps the index
+ * it was added with, which survives compaction and keys its random numbers.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/**
+ * @brief minimal allocator returning 64-byte aligned storage
+ */
+template <typename T>
+struct Aligned_allocator
+{
+    using value_type = T;
+    static constexpr std::size_t alignment = 64;
+
+    Aligned_allocator() = default;
+    template <typename U>
+    Aligned_allocator(const Aligned_allocator<U>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        std::size_t bytes = ((n * sizeof(T) + alignment - 1) / alignment) * alignment;
+        void* p = std::aligned_alloc(alignment, bytes ? bytes : alignment);
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, std::size_t) {std::free(p);}
+
+    template <typename U>
+    bool operator==(const Aligned_allocator<U>&) const {return true;}
+    template <typename U>
+    bool operator!=(const Aligned_allocator<U>&) const {return false;}
+};
+
+using aligned_vector = std::vector<float, Aligned_allocator<float>>;
+using aligned_id_vector = std::vector<std::uint32_t, Aligned_allocator<std::uint32_t>>;
+
+class Carrier_store
+{
+    public:
+        Carrier_store() = default;
+        ~Carrier_store() = default;
+
+        void reserve(std::size_t);
+        void clear();
+        void push_back(float, float, float weight = 1.);
+        std::size_t compact(float, float, float, float);
+
+        inline std::size_t size() const {return _x.size();}
+        inline bool empty() const {return _x.empty();}
+
+        inline float* x(){return _x.data();}
+        inline float* y(){return _y.data();}
+        inline float* vx(){return _vx.data();}
+        inline float* vy(){return _vy.data();}
+        inline float* weight(){return _w.data();}
+        inline const std::uint32_t* id() const {return _id.data();}
+        inline const float* x() const {return _x.data();}
+        inline const float* y() const {return _y.data();}
+        inline const float* vx() const {return _vx.data();}
+        inline const float* vy() const {return _vy.data();}
+        inline const float* weight() const {return _w.data();}
+
+    private:
+        aligned_vector _x;
+        aligned_vector _y;
+        aligned_vector _vx;
+        aligned_vector _vy;
+        aligned_vector _w;
+        aligned_id_vector _id;
+};
+
+#endif
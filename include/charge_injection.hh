@@ -6,11 +6,17 @@
  * @author D. Rosich
  * 
  * Handles the injection of charge carriers into a detector. Stores and manages 
- * electrons or holes as Charge_carrier objects.
+ * electrons or holes in a structure-of-arrays Carrier_store. Carriers are
+ * either sampled for one focus or taken from a shared Beam_template.
  */
 
-#include "charge_carrier.hh"
+#include "beam_template.hh"
+#include "carrier_store.hh"
 #include "detector.hh"
+#include "field_map.hh"
+#include "velocity_table.hh"
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <random>
 #include <utility>
@@ -19,13 +25,17 @@
 class Charge_injection
 {
     public:
-        Charge_injection(float, float, float, float, Detector*, int, int);
+        Charge_injection(float, float, float, float, Detector*, int, int,
+                         std::uint64_t seed = std::random_device{}(),
+                         float importance_fraction = 0.);
+        Charge_injection(const Beam_template&, float, Detector*, int);
         ~Charge_injection() = default;
 
         void set_type(int);
         void update_speeds();
 
-        std::vector<Charge_carrier>& get_charges();
+        Carrier_store& get_charges();
+        const Velocity_table& get_velocity_table() const;
 
     private:
         int _type;
@@ -36,16 +46,18 @@ class Charge_injection
         float _refractive_index;
         Detector* _det;
 
-        std::vector<Charge_carrier> _charges;
+        Carrier_store _charges;
         std::vector<std::pair<float, float>> _charges_per_point_init;
+        std::vector<float> _weights_per_point_init;
 
-        std::vector<float> _E_field_experimental_range;
-        std::vector<float> _velocity_exp;
+        Velocity_table _velocity_table;
+        std::shared_ptr<const Field_map> _field;
 
         float _compute_beam_width(float);
-        std::vector<std::pair<float, float>> _compute_xy_beam(int, float, float, unsigned seed = std::random_device{}(),
-                                                            int grid_for_max_search = 2000);
+        std::vector<std::pair<float, float>> _compute_xy_beam(int, float, float, std::uint64_t seed = std::random_device{}(),
+                                                            float importance_fraction = 0.);
         void _create_injection();
+        void _load_velocity_table();
 };
 
 #endif
\ No newline at end of file
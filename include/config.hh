@@ -5,12 +5,17 @@
  * @class Config
  * @author D. Rosich
  * 
- * json reader. Loads the configuration file passed by the user
+ * json reader. Loads the configuration file passed by the user and parses it
+ * once into a validated Simulation_params block (see simulation_params.hh).
+ * The getters return the parsed values and never touch the json
  */
 
+#include <cstdint>
 #include <string>
 #include <nlohmann/json.hpp>
 
+#include "simulation_params.hh"
+
 class Config {
 public:
     explicit Config(const std::string& filepath);
@@ -23,24 +28,35 @@ public:
     float get_V_bi() const;
     float get_V_bias() const;
     float get_R() const;
+    float get_electrode_width() const;
     std::string get_material() const;
+    std::string get_field_model() const;
+    std::string get_geometry() const;
 
     // Injection parameters
     float get_focus() const;
     float get_wavelength() const;
     float get_NA() const;
     float get_refractive_index() const;
-    int get_type() const;
     int get_N() const;
+    float get_importance_fraction() const;
 
     // Simulation
     int get_steps() const;
     float get_dt() const;
     float get_t_pc() const;
     std::string get_sim_type() const;
+    std::string get_engine() const;
+    bool get_diffusion() const;
+    bool get_trapping() const;
+    int get_threads() const;
+    std::uint64_t get_seed() const;
+
+    inline const Simulation_params& get_params() const {return _params;}
 
 private:
     nlohmann::json _data;
+    Simulation_params _params;
     void _load_json(const std::string& filepath);
 };
 
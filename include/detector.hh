@@ -1,8 +1,13 @@
 #ifndef _DETECTOR_HH_
 #define _DETECTOR_HH_
 
+#include "material.hh"
+
 #include <string>
 
+// capacitance of the measured sensors (F), used unless detector.C is given
+inline constexpr float DEFAULT_CAPACITANCE = 1.6111e-12;
+
 class Detector
 {
     public:
@@ -16,14 +21,23 @@ class Detector
         inline float get_depleted_width(){return _depleted_width;}
         inline float get_bias_voltage(){return _bias_voltage;}
         inline std::string get_material(){return _material;}
+        inline const Material& get_material_properties(){return *_properties;}
         inline float get_depletion_voltage(){return _depletion_voltage;}
         inline float get_e_diffusion_constant(){return _e_diffusion_constant;}
         inline float get_h_diffusion_constant(){return _h_diffusion_constant;}
         inline float get_e_lifetime(){return _e_lifetime;}
         inline float get_h_lifetime(){return _h_lifetime;}
+        inline float get_fluence(){return _fluence;}
+        inline float get_e_trapping_constant(){return _e_trapping_constant;}
+        inline float get_h_trapping_constant(){return _h_trapping_constant;}
+        float get_e_trapping_time();
+        float get_h_trapping_time();
         inline float get_eps(){return _eps;}
         inline float get_resistance(){return _resistance;}
         inline float get_capacitance(){return _capacitance;}
+        inline float get_electrode_width(){return _electrode_width;}
+        inline std::string get_field_model(){return _field_model;}
+        inline std::string get_geometry(){return _geometry;}
 
         void set_doping_concentration(float);
         void set_physical_width(float);
@@ -32,6 +46,15 @@ class Detector
         void set_built_in_voltage(float);
         void set_material(const std::string&);
         void set_resistance(float);
+        void set_capacitance(float);
+        void set_electrode_width(float);
+        void set_field_model(const std::string&);
+        void set_geometry(const std::string&);
+        void set_e_lifetime(float);
+        void set_h_lifetime(float);
+        void set_fluence(float);
+        void set_e_trapping_constant(float);
+        void set_h_trapping_constant(float);
 
     private:
         float _doping_concentration;
@@ -40,6 +63,7 @@ class Detector
         float _bias_voltage;
         float _built_in_voltage;
         std::string _material;
+        const Material* _properties;
         float _resistance;
 
         float _depleted_width;
@@ -50,7 +74,14 @@ class Detector
         float _h_lifetime;
         float _eps;
 
+        float _fluence;                 // 1 MeV neq fluence (1/m^2)
+        float _e_trapping_constant;     // beta of 1/tau_eff = 1/tau + beta*fluence (m^2/s)
+        float _h_trapping_constant;
+
         float _capacitance;
+        float _electrode_width;
+        std::string _field_model;
+        std::string _geometry;  // "planar" (x, y) or "axisymmetric" (r, y)
 
         float _calculate_depleted_width();
         float _calculate_depletion_voltage();
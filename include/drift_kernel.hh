@@ -0,0 +1,60 @@
+#ifndef _DRIFTKERNEL_HH_
+#define _DRIFTKERNEL_HH_
+
+/**
+ * @brief Vectorized drift kernel
+ * @author D. Rosich
+ *
+ * Advances a population of carriers by one time step. For every carrier the
+ * kernel checks whether it is inside the field region, interpolates the local
+ * field from the electric field map, looks the drift speed up in a
+ * Velocity_table, moves it along the field and accumulates its Ramo current
+ * through the weighting field, all in a single pass over the Carrier_store
+ * arrays. Both maps share one grid, so each carrier is located only once.
+ * Carriers in the field region also take a gaussian diffusion step drawn
+ * from the counter-based generator in random.hh. Trapping is a deterministic
+ * decay of the weight of every carrier, w *= exp(-dt/tau), so it needs no
+ * branch or random number and adds no noise.
+ * In the axisymmetric geometry x is the signed radius: the drift stays in the
+ * (r, y) plane and the diffusion step is taken in 3D and folded back onto it.
+ */
+
+#include "carrier_store.hh"
+#include "field_map.hh"
+#include "velocity_table.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+class Detector;
+
+/**
+ * @struct Drift_params
+ *
+ * Per-step constants of the drift kernel. Built once per step from the
+ * detector so the kernel itself never touches Detector or Config.
+ */
+struct Drift_params
+{
+    float dt;           // time step (s)
+    int type;           // carrier type. 0->electrons (drift towards +y), 1->holes
+    float y_max;        // upper edge of the field region (m)
+    float x_half;       // half length of the field region (m)
+    const float* v;     // Velocity_table nodes (m/s)
+    const float* dv;    // Velocity_table node differences (m/s)
+    float inv_dE;       // 1/field spacing of the table (m/V)
+    float max_index;    // last bin of the table
+    float sigma;        // diffusion step per axis, sqrt(2*D*dt) (m). 0 disables it
+    float decay;        // weight kept over the step, exp(-dt/tau). 1 disables trapping
+    bool axisymmetric;  // x is the signed radius of a cylindrical sensor
+    std::uint32_t key0; // generator key, low word of the run seed
+    std::uint32_t key1; // generator key, high word of the run seed
+    std::uint32_t counter;  // step and species, second counter word
+    Field_view field;       // electric field (V/m), see electric_field.hh
+    Field_view weighting;   // Ramo weighting field (1/m), on the grid of field
+};
+
+Drift_params make_drift_params(Detector*, const Velocity_table&, int, float);
+float drift_kernel(Carrier_store&, std::size_t, std::size_t, const Drift_params&);
+
+#endif
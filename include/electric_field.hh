@@ -0,0 +1,34 @@
+#ifndef _ELECTRICFIELD_HH_
+#define _ELECTRICFIELD_HH_
+
+/**
+ * @brief Electric field map of the detector
+ * @author D. Rosich
+ *
+ * The drift field is tabulated once per geometry and bias on the grid of the
+ * weighting field ([-L/2, L/2] x [0, depth], same nodes), so the transport
+ * kernel locates a carrier once and reads both maps with the same bilinear
+ * weights. The field is stored with the sign convention of linear_field:
+ * positive along the direction electrons drift.
+ *
+ * Two models are available, selected with Detector::set_field_model():
+ *   - "linear": linear_field sampled on the nodes
+ *   - "poisson": the potential solved with the multigrid Poisson solver for
+ *     the space charge of the doping, with the same potential drop across
+ *     the field region as the linear model
+ *
+ * Maps are cached by model, geometry and bias, so every pulse of a run
+ * shares one solve.
+ */
+
+#include "field_map.hh"
+
+#include <functional>
+#include <memory>
+
+class Detector;
+
+std::shared_ptr<const Field_map> electric_field(Detector*);
+std::shared_ptr<Field_map> solve_electric_field(Detector*, const std::function<float(float, float)>&);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _ELECTRONICS_HH_
+#define _ELECTRONICS_HH_
+
+/**
+ * @brief Response of the readout electronics
+ * @author D. Rosich
+ *
+ * An Electronics_response turns the induced current into the filtered pulse.
+ * It is chosen by the electronics section of the configuration:
+ *   - "rc": the first-order RC low-pass of the detector capacitance and the
+ *     input resistance (the default)
+ *   - "shaper": the RC stage followed by a CR-RC^n shaper of the given order
+ *     and shaping time
+ *   - "measured": an impulse response read from a csv file (t, h per line),
+ *     which replaces the RC stage
+ * The shaper and measured responses are normalised to unit area, so the
+ * filtered pulse keeps the charge of the current, and scaled by the gain.
+ *
+ * Finite responses are applied with an FFT overlap-add convolution: the
+ * spectrum of the response is computed once and every pulse costs
+ * O(n log m) for n samples and a response of m samples instead of O(n m).
+ * apply_batch() convolves the pulses of a batch two at a time, packed as the
+ * real and imaginary parts of one complex transform.
+ */
+
+#include "fft.hh"
+#include "simulation_params.hh"
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+class Electronics_response
+{
+    public:
+        virtual ~Electronics_response() = default;
+
+        /**
+         * @brief filter a batch of waveforms
+         *
+         * @param in waveforms of n samples
+         * @param out filtered waveforms of n samples, one per input. Must
+         *            not alias the inputs
+         * @param n samples per waveform
+         */
+        virtual void apply_batch(const std::vector<const float*>& in, const std::vector<float*>& out,
+                                 std::size_t n) const = 0;
+
+        void apply(const float*, float*, std::size_t) const;
+};
+
+/**
+ * @class Rc_response
+ *
+ * first-order RC low-pass, filtered[i] = a*signal[i] + (1 - a)*filtered[i-1]
+ * with a = dt/(RC + dt). Passes the signal unfiltered if R is not positive
+ */
+class Rc_response : public Electronics_response
+{
+    public:
+        Rc_response(float, float, float, float gain = 1.);
+
+        void apply_batch(const std::vector<const float*>&, const std::vector<float*>&, std::size_t) const override;
+
+    private:
+        float _alpha;
+        float _gain;
+};
+
+/**
+ * @class Fir_response
+ *
+ * convolution with a sampled impulse response, output truncated to the
+ * length of the input
+ */
+class Fir_response : public Electronics_response
+{
+    public:
+        explicit Fir_response(const std::vector<float>&);
+
+        void apply_batch(const std::vector<const float*>&, const std::vector<float*>&, std::size_t) const override;
+
+        inline const std::vector<float>& get_taps() const {return _taps;}
+
+    private:
+        std::vector<float> _taps;
+        Fft_plan _plan;
+        std::size_t _block;                         // input samples per block
+        std::vector<std::complex<float>> _spectrum; // transform of the taps
+
+        void _convolve(const float*, const float*, float*, float*, std::size_t) const;
+};
+
+std::shared_ptr<const Electronics_response> electronics_response(const Simulation_params&);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _FFT_HH_
+#define _FFT_HH_
+
+/**
+ * @class Fft_plan
+ * @author D. Rosich
+ *
+ * In-place radix-2 complex FFT of a fixed power-of-two size. The twiddle
+ * factors and the bit-reversal permutation are computed once by the
+ * constructor, so a plan is built once and reused for every transform of
+ * that size. A plan is read-only after construction and can be shared
+ * between threads.
+ */
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+class Fft_plan
+{
+    public:
+        explicit Fft_plan(std::size_t);
+
+        void forward(std::complex<float>*) const;
+        void inverse(std::complex<float>*) const;
+
+        inline std::size_t get_size() const {return _n;}
+
+    private:
+        std::size_t _n;
+        std::vector<std::complex<float>> _twiddles;     // exp(-2 pi i k / n), k < n/2
+        std::vector<std::size_t> _reversed;
+
+        void _transform(std::complex<float>*, bool) const;
+};
+
+std::size_t next_power_of_two(std::size_t);
+void multiply_spectrum(std::complex<float>*, const std::complex<float>*, std::size_t);
+
+#endif
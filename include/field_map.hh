@@ -0,0 +1,158 @@
+#ifndef _FIELDMAP_HH_
+#define _FIELDMAP_HH_
+
+/**
+ * @class Field_map
+ * @author D. Rosich
+ *
+ * 2D vector field (x and y components) sampled on a uniform grid of nodes
+ * covering a rectangle of the detector. Values between nodes are obtained by
+ * bilinear interpolation, either one point at a time or, through a
+ * Field_view, inside the SIMD transport kernels. Outside the rectangle the
+ * field of the closest edge is returned. The map is small (a few hundred KB
+ * at most) and is read through gathers, so it is kept as two planar arrays.
+ */
+
+#include "carrier_store.hh"
+
+#include <cstddef>
+
+/**
+ * @struct Field_view
+ *
+ * plain pointers and constants of a Field_map, cheap to copy into the kernel
+ * parameters
+ */
+struct Field_view
+{
+    const float* fx;    // x component at the nodes, row-major in y. nullptr if 0 everywhere
+    const float* fy;    // y component at the nodes. nullptr if 0 everywhere
+    float x_min;        // position of the first node (m)
+    float y_min;
+    float inv_dx;       // 1/node spacing (1/m)
+    float inv_dy;
+    float nx;           // nodes per row, as float for the kernels
+    float max_i;        // last cell along x (nx - 2)
+    float max_j;        // last cell along y (ny - 2)
+};
+
+class Field_map
+{
+    public:
+        Field_map(int, int, float, float, float, float);
+        ~Field_map() = default;
+
+        void sample(float, float, float&, float&) const;
+        Field_view view() const;
+        void drop_round_off(float);
+
+        inline int get_nx() const {return _nx;}
+        inline int get_ny() const {return _ny;}
+        inline float get_x(int i) const {return _x_min + i*_dx;}
+        inline float get_y(int j) const {return _y_min + j*_dy;}
+        inline float get_dx() const {return _dx;}
+        inline float get_dy() const {return _dy;}
+        inline float* fx(){return _fx.data();}
+        inline float* fy(){return _fy.data();}
+        inline const float* fx() const {return _fx.data();}
+        inline const float* fy() const {return _fy.data();}
+
+    private:
+        int _nx;
+        int _ny;
+        float _x_min;
+        float _y_min;
+        float _dx;
+        float _dy;
+        aligned_vector _fx;
+        aligned_vector _fy;
+
+        Field_view _view(bool) const;
+};
+
+/**
+ * @struct Field_cell
+ *
+ * grid cell and bilinear weights of a batch of points. Maps built on the
+ * same grid (the electric and the weighting field) share one Field_cell, so
+ * the index arithmetic is done once per point and the four corners of every
+ * map are fetched from the same node indices
+ */
+template <class V>
+struct Field_cell
+{
+    typename V::vf i00; // node index of the lower left corner
+    typename V::vf tx;  // position inside the cell, [0, 1]
+    typename V::vf ty;
+};
+
+/**
+ * @brief locate points on the grid of a field view
+ *
+ * points outside the grid are clamped to its edge
+ *
+ * @param m field
+ * @param x x coordinates (m)
+ * @param y y coordinates (m)
+ *
+ * @returns cell and weights of the points
+ */
+template <class V>
+inline Field_cell<V> locate(const Field_view& m, typename V::vf x, typename V::vf y)
+{
+    const typename V::vf zero = V::set1(0.);
+    typename V::vf u = V::mul(V::sub(x, V::set1(m.x_min)), V::set1(m.inv_dx));
+    typename V::vf v = V::mul(V::sub(y, V::set1(m.y_min)), V::set1(m.inv_dy));
+    u = V::min(V::max(u, zero), V::set1(m.max_i + 1.));
+    v = V::min(V::max(v, zero), V::set1(m.max_j + 1.));
+    typename V::vf i = V::min(V::trunc(u), V::set1(m.max_i));
+    typename V::vf j = V::min(V::trunc(v), V::set1(m.max_j));
+
+    Field_cell<V> c;
+    c.i00 = V::fmadd(j, V::set1(m.nx), i);
+    c.tx = V::sub(u, i);
+    c.ty = V::sub(v, j);
+    return c;
+}
+
+/**
+ * @brief bilinear interpolation of one component
+ *
+ * @param c cell of the points (see locate)
+ * @param f component at the nodes, nullptr for a component that is 0
+ * @param nx nodes per row
+ *
+ * @returns interpolated values
+ */
+template <class V>
+inline typename V::vf interpolate(const Field_cell<V>& c, const float* f, float nx)
+{
+    if (!f) return V::set1(0.);
+    // the two corners of a row are neighbours: one pair gather per row
+    typename V::vf a, b, d, e;
+    V::gather_pair(f, c.i00, a, b);
+    V::gather_pair(f, V::add(c.i00, V::set1(nx)), d, e);
+    typename V::vf bottom = V::fmadd(c.tx, V::sub(b, a), a);
+    typename V::vf top = V::fmadd(c.tx, V::sub(e, d), d);
+    return V::fmadd(c.ty, V::sub(top, bottom), bottom);
+}
+
+/**
+ * @brief bilinear interpolation of a field view
+ *
+ * @param m field
+ * @param x x coordinates (m)
+ * @param y y coordinates (m)
+ * @param fx x component at (x, y)
+ * @param fy y component at (x, y)
+ */
+template <class V>
+inline void bilinear(const Field_view& m, typename V::vf x, typename V::vf y,
+                     typename V::vf& fx, typename V::vf& fy)
+{
+    Field_cell<V> c = locate<V>(m, x, y);
+    fx = interpolate<V>(c, m.fx, m.nx);
+    fy = interpolate<V>(c, m.fy, m.nx);
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef _MATERIAL_HH_
+#define _MATERIAL_HH_
+
+/**
+ * @brief Properties of the detector materials
+ * @author D. Rosich
+ *
+ * Compile-time table of the sensor materials the simulation knows: the
+ * permittivity and, per carrier type, the diffusion constant, the trapping
+ * time of the unirradiated material and the Caughey-Thomas parameters of the
+ * drift velocity, v(E) = mu E / (1 + (mu E/v_sat)^beta)^(1/beta). Materials
+ * with a measured v(E) in exp_data/ name it and use it instead. Values are
+ * at room temperature, in SI units; diffusion constants follow from the
+ * mobility through the Einstein relation where no measurement is used.
+ *
+ * A material is looked up by name once, when a Detector is built or its
+ * material changes; an unknown name is an error.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @struct Carrier_properties
+ *
+ * transport of one carrier type in a material
+ */
+struct Carrier_properties
+{
+    float diffusion_constant;   // (m^2/s)
+    float lifetime;             // trapping time before irradiation (s)
+    float mobility;             // low field mobility (m^2/Vs)
+    float saturation_velocity;  // (m/s)
+    float exponent;             // beta of the Caughey-Thomas v(E)
+    const char* velocity_curve; // measured v(E) in exp_data/ (MV/cm, cm/s). nullptr: Caughey-Thomas
+};
+
+/**
+ * @struct Material
+ */
+struct Material
+{
+    const char* name;
+    float eps;                  // relative permittivity
+    Carrier_properties e;       // electrons
+    Carrier_properties h;       // holes
+};
+
+inline constexpr Material MATERIALS[] = {
+    // 4H-SiC, with the measured drift velocities
+    {"SiC", 9.72,
+        {22.e-4, 1.e-9, 0.0851, 2.2e5, 1.2, "electron_drift_velocity.csv"},
+        {3.e-4, 6.e-7, 0.0116, 1.0e5, 1.2, "hole_drift_velocity.csv"}},
+    // Canali et al., IEEE TED 22 (1975)
+    {"Si", 11.9,
+        {36.6e-4, 1.e-3, 0.1417, 1.07e5, 1.109, nullptr},
+        {12.2e-4, 1.e-3, 0.0471, 0.837e5, 1.213, nullptr}},
+    // single crystal CVD, Pernegger et al., J. Appl. Phys. 97 (2005)
+    {"diamond", 5.7,
+        {44.3e-4, 1.e-6, 0.1714, 0.96e5, 1., nullptr},
+        {53.4e-4, 1.e-6, 0.2064, 1.41e5, 1., nullptr}},
+    // wurtzite GaN
+    {"GaN", 8.9,
+        {25.9e-4, 1.e-9, 0.100, 1.9e5, 1., nullptr},
+        {0.78e-4, 1.e-9, 0.0030, 0.7e5, 1., nullptr}},
+};
+
+inline constexpr std::size_t N_MATERIALS = sizeof(MATERIALS)/sizeof(MATERIALS[0]);
+
+/**
+ * @brief look a material up by name
+ *
+ * @returns the material, nullptr if it is not in the table
+ */
+inline const Material* find_material(const std::string& name)
+{
+    for (const Material& m : MATERIALS)
+        if (name == m.name) return &m;
+    return nullptr;
+}
+
+/**
+ * @brief names of the known materials, for the configuration checks
+ */
+inline std::vector<std::string> material_names()
+{
+    std::vector<std::string> names;
+    for (const Material& m : MATERIALS)
+        names.push_back(m.name);
+    return names;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef _NPY_HH_
+#define _NPY_HH_
+
+/**
+ * @class Npy_writer
+ * @author D. Rosich
+ *
+ * Streams a float32 array to a NumPy .npy file one row at a time. The
+ * number of rows does not need to be known in advance: the header is written
+ * with a fixed size and its shape is patched when the file is closed. The
+ * result loads with numpy.load (also memory mapped).
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Npy_writer
+{
+    public:
+        Npy_writer(const std::string&, std::size_t);
+        ~Npy_writer();
+
+        Npy_writer(const Npy_writer&) = delete;
+        Npy_writer& operator=(const Npy_writer&) = delete;
+
+        void write_row(const float*);
+        void close();
+
+        inline std::size_t get_rows() const {return _rows;}
+        inline std::size_t get_bytes_written() const {return _bytes;}
+
+    private:
+        std::ofstream _file;
+        std::string _path;
+        std::size_t _row_size;
+        std::size_t _rows;
+        std::size_t _bytes;
+
+        void _write_header();
+};
+
+/**
+ * @class Npy_array
+ * @author D. Rosich
+ *
+ * Read-only memory map of a NumPy .npy file holding a little-endian float32
+ * or float64 array in C order (what numpy.save writes by default). Only the
+ * header is parsed when the file is opened; the values are paged in by the
+ * system as they are read.
+ */
+class Npy_array
+{
+    public:
+        Npy_array(const std::string&);
+        ~Npy_array();
+
+        Npy_array(const Npy_array&) = delete;
+        Npy_array& operator=(const Npy_array&) = delete;
+
+        inline const std::vector<std::size_t>& get_shape() const {return _shape;}
+        inline std::size_t size() const {return _size;}
+
+        /**
+         * @brief value of the flattened array, as a double
+         */
+        inline double operator[](std::size_t i) const
+        {
+            if (_double)
+            {
+                double v;
+                std::memcpy(&v, _values + i*sizeof(double), sizeof(double));
+                return v;
+            }
+            float v;
+            std::memcpy(&v, _values + i*sizeof(float), sizeof(float));
+            return v;
+        }
+
+    private:
+        void* _map;
+        std::size_t _map_size;
+        const char* _values;
+        bool _double;
+        std::vector<std::size_t> _shape;
+        std::size_t _size;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef _PLOTTING_HH_
+#define _PLOTTING_HH_
+
+/**
+ * @brief ROOT plotting helpers
+ *
+ * @author D. Rosich
+ *
+ * Only built with TCT_WITH_ROOT. The simulation core does not depend on ROOT
+ */
+
+#include <TH2F.h>
+
+class Detector;
+
+TH2F* plot_E_field(float, float, int, float, float, int, Detector*);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef _POISSON_HH_
+#define _POISSON_HH_
+
+/**
+ * @brief Multigrid Poisson solver on the detector cross-section
+ * @author D. Rosich
+ *
+ * Solves lap(phi) = rhs on a uniform grid of nx x ny nodes. The first and
+ * last rows (y edges, the electrodes) are Dirichlet and keep the values they
+ * hold on entry; the x edges are Neumann (no flux through the sides of the
+ * sensor). V-cycles with red-black Gauss-Seidel smoothing are run until the
+ * residual drops below the tolerance.
+ *
+ * solve_poisson_axisymmetric solves the same problem on the (r, y)
+ * half-plane of a cylindrical sensor, where the Laplacian has the extra
+ * (1/r) d/dr term. The axis is regular and the outer radius Neumann; it
+ * relaxes whole columns at once (line SOR along y).
+ */
+
+#include <vector>
+
+void solve_poisson(std::vector<double>&, const std::vector<double>&, int, int, double, double,
+                   double tol = 1e-10, int max_cycles = 100);
+void solve_poisson_axisymmetric(std::vector<double>&, const std::vector<double>&, int, int, double, double,
+                                double tol = 1e-10, int max_sweeps = 100000);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef _PROFILER_HH_
+#define _PROFILER_HH_
+
+/**
+ * @brief Per-phase timers and counters
+ * @author D. Rosich
+ *
+ * The phases of a run (injection sampling, transport steps, readout, output)
+ * are timed by TCT_PROFILE_SCOPE("phase") and measured quantities are
+ * recorded by TCT_PROFILE_COUNT("counter", value). Both expand to nothing
+ * unless the core is built with TCT_PROFILING (CMake option of the same
+ * name), in which case:
+ *   - every thread accumulates into its own log, without locks: calls, total
+ *     and largest duration per phase; count, sum, min and max per counter
+ *   - with profile_enable_trace(), every scope is also kept as an event and
+ *     written as a Chrome trace (chrome://tracing, Perfetto)
+ * profile_report() merges the logs of all threads. It, profile_reset() and
+ * write_profile_trace() must be called while no instrumented code runs.
+ * Names are string literals; the same name in several places is one phase.
+ */
+
+#include <chrono>
+#include <string>
+#include <nlohmann/json.hpp>
+
+/**
+ * @class Profile_scope
+ *
+ * times the enclosing scope as one call of a phase
+ */
+class Profile_scope
+{
+    public:
+        explicit Profile_scope(const char*);
+        ~Profile_scope();
+
+        Profile_scope(const Profile_scope&) = delete;
+        Profile_scope& operator=(const Profile_scope&) = delete;
+
+    private:
+        const char* _name;
+        std::chrono::steady_clock::time_point _start;
+};
+
+void profile_count(const char*, double);
+void profile_reset();
+void profile_enable_trace(bool);
+nlohmann::json profile_report();
+void write_profile_trace(const std::string&);
+
+#ifdef TCT_PROFILING
+#define TCT_PROFILE_CAT_(a, b) a##b
+#define TCT_PROFILE_CAT(a, b) TCT_PROFILE_CAT_(a, b)
+#define TCT_PROFILE_SCOPE(name) Profile_scope TCT_PROFILE_CAT(_profile_scope_, __LINE__)(name)
+#define TCT_PROFILE_COUNT(name, value) profile_count(name, value)
+#else
+#define TCT_PROFILE_SCOPE(name) ((void)0)
+#define TCT_PROFILE_COUNT(name, value) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef _PULSE_HH_
+#define _PULSE_HH_
+
+/**
+ * @brief Simulation of a single TPA-TCT pulse
+ *
+ * @author D. Rosich
+ */
+
+#include "beam_template.hh"
+#include "simulation_params.hh"
+#include "detector.hh"
+#include "electronics.hh"
+#include "thread_pool.hh"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct Pulse
+ *
+ * waveforms and figures of merit of one simulated pulse
+ */
+struct Pulse
+{
+    float focus;                    // laser focus depth (m)
+    std::vector<float> signal_e;    // electron induced current (A)
+    std::vector<float> signal_h;    // hole induced current (A)
+    std::vector<float> signal_total;
+    std::vector<float> filtered;    // signal_total after the readout filter
+    float charge;                   // integral of signal_total (C)
+    float WPC;                      // filtered pulse at t_pc (A)
+};
+
+Pulse simulate_pulse(float, const Simulation_params&, Detector*, std::uint64_t, Thread_pool* pool = nullptr);
+Pulse simulate_pulse(const Beam_template&, float, const Simulation_params&, Detector*, std::uint64_t,
+                     Thread_pool* pool = nullptr);
+void apply_readout(Pulse&, const Electronics_response&, float, float);
+void apply_readout(const std::vector<Pulse*>&, const Electronics_response&, float, float);
+std::uint64_t derive_seed(std::uint64_t, std::uint64_t);
+
+#endif
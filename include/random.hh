@@ -0,0 +1,78 @@
+#ifndef _RANDOM_HH_
+#define _RANDOM_HH_
+
+/**
+ * @brief Counter-based random numbers for the transport kernels
+ * @author D. Rosich
+ *
+ * Threefry-2x32 (20 rounds) turns a (key, counter) pair into two random
+ * 32-bit words with nothing but additions, rotations and xors, so it runs on
+ * any of the simd wrappers and needs no state. Keying it with the run seed
+ * and counting with (carrier id, step) gives every carrier and step its own
+ * numbers whatever thread or SIMD lane processes it. Gaussian deviates are
+ * obtained from a tabulated inverse normal CDF.
+ */
+
+#include <cstdint>
+
+namespace rng
+{
+
+/**
+ * @brief Threefry-2x32-20 block
+ *
+ * @param k0 first key word
+ * @param k1 second key word
+ * @param x0 first counter word, replaced by the first output word
+ * @param x1 second counter word, replaced by the second output word
+ */
+template <class V>
+inline void threefry2x32(std::uint32_t k0, std::uint32_t k1, typename V::vi& x0, typename V::vi& x1)
+{
+    static constexpr int R[8] = {13, 15, 26, 6, 17, 29, 16, 24};
+    const typename V::vi ks[3] = {V::set1_u(k0), V::set1_u(k1), V::set1_u(0x1BD11BDA ^ k0 ^ k1)};
+
+    x0 = V::add_u(x0, ks[0]);
+    x1 = V::add_u(x1, ks[1]);
+    for (int i = 0; i < 5; ++i)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            x0 = V::add_u(x0, x1);
+            x1 = V::rotl_u(x1, R[(4*i + r) % 8]);
+            x1 = V::xor_u(x1, x0);
+        }
+        x0 = V::add_u(x0, ks[(i + 1) % 3]);
+        x1 = V::add_u(V::add_u(x1, ks[(i + 2) % 3]), V::set1_u(i + 1));
+    }
+}
+
+/**
+ * @struct Normal_table
+ *
+ * inverse CDF of the standard normal distribution on a uniform grid of
+ * probabilities, laid out like Velocity_table (nodes and differences)
+ */
+struct Normal_table
+{
+    static constexpr int n_bins = 4096;
+    alignas(64) float g[n_bins + 1];    // inverse CDF at the nodes
+    alignas(64) float dg[n_bins + 1];   // g[i+1] - g[i]
+};
+
+const Normal_table& normal_table();
+
+/**
+ * @brief map uniform deviates in [0, 1) to standard normal deviates
+ */
+template <class V>
+inline typename V::vf normal(const Normal_table& t, typename V::vf u)
+{
+    typename V::vf f = V::mul(u, V::set1(Normal_table::n_bins));
+    typename V::vf idx = V::trunc(f);
+    return V::fmadd(V::sub(f, idx), V::gather(t.dg, idx), V::gather(t.g, idx));
+}
+
+}
+
+#endif
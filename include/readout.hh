@@ -0,0 +1,16 @@
+#ifndef _READOUT_HH_
+#define _READOUT_HH_
+
+/**
+ * @brief Readout of the induced current
+ *
+ * @author D. Rosich
+ */
+
+#include <cstddef>
+#include <vector>
+
+std::vector<float> rc_filter(const std::vector<float>&, float, float, float);
+float integrate_charge(const std::vector<float>&, float);
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef _RESOURCECACHE_HH_
+#define _RESOURCECACHE_HH_
+
+/**
+ * @class Resource_cache
+ * @author D. Rosich
+ *
+ * Bounded cache of the resources a run builds once and shares between its
+ * scan points and threads (field maps, readout responses, beam profiles,
+ * v(E) curves). An entry is built by the first thread that asks for its key,
+ * outside the lock: other keys are served meanwhile and the threads asking
+ * for the same key wait for that build. Past the capacity the least recently
+ * used entry is dropped; holders keep their copy alive. A failed build is
+ * not kept, so the next call tries again.
+ *
+ * clear_resource_caches() empties every cache of the program, for hosts
+ * (the Python interface) that run many configurations in one process.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/**
+ * @class Resource_cache_base
+ *
+ * registers a cache for clear_resource_caches()
+ */
+class Resource_cache_base
+{
+    public:
+        virtual void clear() = 0;
+
+        Resource_cache_base(const Resource_cache_base&) = delete;
+        Resource_cache_base& operator=(const Resource_cache_base&) = delete;
+
+    protected:
+        Resource_cache_base();
+        virtual ~Resource_cache_base();
+};
+
+void clear_resource_caches();
+
+template <class Key, class T>
+class Resource_cache : public Resource_cache_base
+{
+    public:
+        explicit Resource_cache(std::size_t capacity) : _capacity(capacity) {}
+
+        template <class F>
+        std::shared_ptr<const T> get(const Key&, F&& build);
+        void clear() override;
+
+    private:
+        struct Entry
+        {
+            std::shared_future<std::shared_ptr<const T>> value;
+            std::uint64_t build;        // clock when the build started
+            std::uint64_t last_use;
+        };
+
+        std::size_t _capacity;
+        std::uint64_t _clock = 0;
+        std::map<Key, Entry> _entries;
+        std::mutex _mutex;
+};
+
+/**
+ * @brief cached resource of a key
+ *
+ * @param key key of the resource
+ * @param build callable returning the resource (convertible to
+ *              std::shared_ptr<const T>), called if the key is not cached
+ *
+ * @returns the resource
+ *
+ * @throws what build throws, to every caller waiting for that build
+ */
+template <class Key, class T>
+template <class F>
+std::shared_ptr<const T> Resource_cache<Key, T>::get(const Key& key, F&& build)
+{
+    std::promise<std::shared_ptr<const T>> promise;
+    std::shared_future<std::shared_ptr<const T>> value;
+    std::uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _entries.find(key);
+        if (it != _entries.end())
+        {
+            it->second.last_use = ++_clock;
+            value = it->second.value;
+        }
+        else
+        {
+            // a linear search is enough for the few entries of a run
+            if (_entries.size() >= _capacity && !_entries.empty())
+            {
+                auto oldest = _entries.begin();
+                for (auto e = _entries.begin(); e != _entries.end(); ++e)
+                    if (e->second.last_use < oldest->second.last_use) oldest = e;
+                _entries.erase(oldest);
+            }
+            id = ++_clock;
+            _entries[key] = {promise.get_future().share(), id, id};
+        }
+    }
+    if (value.valid())
+        return value.get();
+
+    try {
+        std::shared_ptr<const T> resource = build();
+        promise.set_value(resource);
+        return resource;
+    }
+    catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _entries.find(key);
+        if (it != _entries.end() && it->second.build == id)
+            _entries.erase(it);
+        throw;
+    }
+}
+
+/**
+ * @brief drop every entry
+ */
+template <class Key, class T>
+void Resource_cache<Key, T>::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+#endif
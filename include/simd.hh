@@ -0,0 +1,211 @@
+#ifndef _SIMD_HH_
+#define _SIMD_HH_
+
+/**
+ * @brief Thin SIMD wrappers used by the transport kernels
+ * @author D. Rosich
+ *
+ * Each wrapper exposes the same small set of operations so a kernel can be
+ * written once as a template and instantiated for the widest instruction set
+ * the compiler targets (AVX-512, AVX2) plus a scalar version used for the
+ * tails and as a fallback on other architectures. The unsigned 32-bit lane
+ * operations (vi) are what the counter-based generator in random.hh needs.
+ * gather_pair fetches two neighbouring floats per lane with a single 64-bit
+ * gather, which halves the gathers of a bilinear lookup.
+ */
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// GCC builds the unmasked AVX-512 intrinsics on an _mm512_undefined_*()
+// pass-through and, once they are inlined into a loop, reports it as
+// maybe-uninitialized. The value is never read: silence it for these
+// headers only
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+namespace simd
+{
+
+/**
+ * @brief scalar fallback. One lane, plain floats
+ */
+struct Scalar
+{
+    static constexpr int width = 1;
+    using vf = float;
+    using vm = bool;
+    using vi = std::uint32_t;
+
+    static inline vf load(const float* p){return *p;}
+    static inline void store(float* p, vf a){*p = a;}
+    static inline vf set1(float a){return a;}
+    static inline vf add(vf a, vf b){return a + b;}
+    static inline vf sub(vf a, vf b){return a - b;}
+    static inline vf mul(vf a, vf b){return a * b;}
+    static inline vf div(vf a, vf b){return a / b;}
+    static inline vf sqrt(vf a){return std::sqrt(a);}
+    static inline vf fmadd(vf a, vf b, vf c){return a * b + c;}
+    static inline vf min(vf a, vf b){return a < b ? a : b;}
+    static inline vf max(vf a, vf b){return a > b ? a : b;}
+    static inline vf trunc(vf a){return std::trunc(a);}
+    static inline vf gather(const float* base, vf idx){return base[static_cast<int>(idx)];}
+    static inline void gather_pair(const float* base, vf idx, vf& a, vf& b)
+    {
+        a = base[static_cast<int>(idx)];
+        b = base[static_cast<int>(idx) + 1];
+    }
+    static inline vm le(vf a, vf b){return a <= b;}
+    static inline vm ge(vf a, vf b){return a >= b;}
+    static inline vm land(vm a, vm b){return a && b;}
+    static inline vf select(vm m, vf a, vf b){return m ? a : b;}
+    static inline float reduce_add(vf a){return a;}
+
+    static inline vi load_u(const std::uint32_t* p){return *p;}
+    static inline vi set1_u(std::uint32_t a){return a;}
+    static inline vi add_u(vi a, vi b){return a + b;}
+    static inline vi xor_u(vi a, vi b){return a ^ b;}
+    static inline vi rotl_u(vi a, int r){return (a << r) | (a >> (32 - r));}
+    static inline vf to_unit(vi a){return (a >> 8) * (1.f/16777216.f);}
+};
+
+#if defined(__AVX512F__)
+/**
+ * @brief AVX-512 wrapper. 16 float lanes, k-register masks
+ */
+struct Avx512
+{
+    static constexpr int width = 16;
+    using vf = __m512;
+    using vm = __mmask16;
+    using vi = __m512i;
+
+    static inline vf load(const float* p){return _mm512_loadu_ps(p);}
+    static inline void store(float* p, vf a){_mm512_storeu_ps(p, a);}
+    static inline vf set1(float a){return _mm512_set1_ps(a);}
+    static inline vf add(vf a, vf b){return _mm512_add_ps(a, b);}
+    static inline vf sub(vf a, vf b){return _mm512_sub_ps(a, b);}
+    static inline vf mul(vf a, vf b){return _mm512_mul_ps(a, b);}
+    static inline vf div(vf a, vf b){return _mm512_div_ps(a, b);}
+    static inline vf sqrt(vf a){return _mm512_sqrt_ps(a);}
+    static inline vf fmadd(vf a, vf b, vf c){return _mm512_fmadd_ps(a, b, c);}
+    static inline vf min(vf a, vf b){return _mm512_min_ps(a, b);}
+    static inline vf max(vf a, vf b){return _mm512_max_ps(a, b);}
+    static inline vf trunc(vf a){return _mm512_roundscale_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);}
+    static inline vf gather(const float* base, vf idx){return _mm512_i32gather_ps(_mm512_cvttps_epi32(idx), base, 4);}
+    static inline void gather_pair(const float* base, vf idx, vf& a, vf& b)
+    {
+        // one 64-bit load per lane fetches base[idx] and base[idx + 1]
+        __m512i i = _mm512_cvttps_epi32(idx);
+        __m512 lo = _mm512_castpd_ps(_mm512_i32gather_pd(_mm512_castsi512_si256(i), base, 4));
+        __m512 hi = _mm512_castpd_ps(_mm512_i32gather_pd(_mm512_extracti64x4_epi64(i, 1), base, 4));
+        const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+        a = _mm512_permutex2var_ps(lo, even, hi);
+        b = _mm512_permutex2var_ps(lo, odd, hi);
+    }
+    static inline vm le(vf a, vf b){return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ);}
+    static inline vm ge(vf a, vf b){return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ);}
+    static inline vm land(vm a, vm b){return a & b;}
+    static inline vf select(vm m, vf a, vf b){return _mm512_mask_blend_ps(m, b, a);}
+    static inline float reduce_add(vf a)
+    {
+        alignas(64) float lanes[width];
+        _mm512_store_ps(lanes, a);
+        float s = 0.;
+        for(int i = 0; i < width; ++i) s += lanes[i];
+        return s;
+    }
+
+    static inline vi load_u(const std::uint32_t* p){return _mm512_loadu_si512(p);}
+    static inline vi set1_u(std::uint32_t a){return _mm512_set1_epi32(static_cast<int>(a));}
+    static inline vi add_u(vi a, vi b){return _mm512_add_epi32(a, b);}
+    static inline vi xor_u(vi a, vi b){return _mm512_xor_si512(a, b);}
+    static inline vi rotl_u(vi a, int r){return _mm512_rolv_epi32(a, _mm512_set1_epi32(r));}
+    static inline vf to_unit(vi a)
+    {
+        return _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(a, 8)), _mm512_set1_ps(1.f/16777216.f));
+    }
+};
+using Native = Avx512;
+#elif defined(__AVX2__)
+/**
+ * @brief AVX2 wrapper. 8 float lanes, masks held as all-ones float lanes
+ */
+struct Avx2
+{
+    static constexpr int width = 8;
+    using vf = __m256;
+    using vm = __m256;
+    using vi = __m256i;
+
+    static inline vf load(const float* p){return _mm256_loadu_ps(p);}
+    static inline void store(float* p, vf a){_mm256_storeu_ps(p, a);}
+    static inline vf set1(float a){return _mm256_set1_ps(a);}
+    static inline vf add(vf a, vf b){return _mm256_add_ps(a, b);}
+    static inline vf sub(vf a, vf b){return _mm256_sub_ps(a, b);}
+    static inline vf mul(vf a, vf b){return _mm256_mul_ps(a, b);}
+    static inline vf div(vf a, vf b){return _mm256_div_ps(a, b);}
+    static inline vf sqrt(vf a){return _mm256_sqrt_ps(a);}
+#if defined(__FMA__)
+    static inline vf fmadd(vf a, vf b, vf c){return _mm256_fmadd_ps(a, b, c);}
+#else
+    static inline vf fmadd(vf a, vf b, vf c){return _mm256_add_ps(_mm256_mul_ps(a, b), c);}
+#endif
+    static inline vf min(vf a, vf b){return _mm256_min_ps(a, b);}
+    static inline vf max(vf a, vf b){return _mm256_max_ps(a, b);}
+    static inline vf trunc(vf a){return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);}
+    static inline vf gather(const float* base, vf idx){return _mm256_i32gather_ps(base, _mm256_cvttps_epi32(idx), 4);}
+    static inline void gather_pair(const float* base, vf idx, vf& a, vf& b)
+    {
+        // one 64-bit load per lane fetches base[idx] and base[idx + 1]
+        const double* pairs = reinterpret_cast<const double*>(base);
+        __m256i i = _mm256_cvttps_epi32(idx);
+        __m256 lo = _mm256_castpd_ps(_mm256_i32gather_pd(pairs, _mm256_castsi256_si128(i), 4));
+        __m256 hi = _mm256_castpd_ps(_mm256_i32gather_pd(pairs, _mm256_extracti128_si256(i, 1), 4));
+        a = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+        b = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    static inline vm le(vf a, vf b){return _mm256_cmp_ps(a, b, _CMP_LE_OQ);}
+    static inline vm ge(vf a, vf b){return _mm256_cmp_ps(a, b, _CMP_GE_OQ);}
+    static inline vm land(vm a, vm b){return _mm256_and_ps(a, b);}
+    static inline vf select(vm m, vf a, vf b){return _mm256_blendv_ps(b, a, m);}
+    static inline float reduce_add(vf a)
+    {
+        alignas(32) float lanes[width];
+        _mm256_store_ps(lanes, a);
+        float s = 0.;
+        for(int i = 0; i < width; ++i) s += lanes[i];
+        return s;
+    }
+
+    static inline vi load_u(const std::uint32_t* p){return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));}
+    static inline vi set1_u(std::uint32_t a){return _mm256_set1_epi32(static_cast<int>(a));}
+    static inline vi add_u(vi a, vi b){return _mm256_add_epi32(a, b);}
+    static inline vi xor_u(vi a, vi b){return _mm256_xor_si256(a, b);}
+    static inline vi rotl_u(vi a, int r)
+    {
+        return _mm256_or_si256(_mm256_sllv_epi32(a, _mm256_set1_epi32(r)),
+                               _mm256_srlv_epi32(a, _mm256_set1_epi32(32 - r)));
+    }
+    static inline vf to_unit(vi a)
+    {
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(a, 8)), _mm256_set1_ps(1.f/16777216.f));
+    }
+};
+using Native = Avx2;
+#else
+using Native = Scalar;
+#endif
+
+}
+
+#endif
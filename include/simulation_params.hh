@@ -0,0 +1,174 @@
+#ifndef _SIMULATIONPARAMS_HH_
+#define _SIMULATIONPARAMS_HH_
+
+/**
+ * @brief Typed simulation parameters
+ * @author D. Rosich
+ *
+ * The configuration file is parsed once into a Simulation_params block. Every
+ * field is read with its default, converted to its C++ type and checked
+ * against a physically sensible range in SI units (a width given in um
+ * instead of m fails here). All the problems of a file are collected and
+ * reported together before anything is simulated, so a bad configuration
+ * fails in a fraction of a second instead of deep inside a scan. The
+ * simulation only reads this block, never the json. Swept values are checked
+ * against the same ranges as the values they replace.
+ */
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class Detector;
+
+/**
+ * @struct Detector_params
+ *
+ * "detector" section
+ */
+struct Detector_params
+{
+    float Nd;               // doping concentration (1/m^3)
+    float width;            // thickness (m)
+    float length;           // lateral size (m)
+    float V_bi;             // built-in voltage (V)
+    float V_bias;           // bias voltage (V)
+    float R;                // readout resistance (Ohm)
+    float C;                // detector capacitance (F)
+    float electrode_width;  // readout strip width (m). Defaults to length
+    std::string material;   // one of material.hh
+    std::string field_model;    // "linear" or "poisson"
+    std::string geometry;       // "planar" or "axisymmetric"
+    float e_lifetime;       // electron trapping time before irradiation (s). 0: the material's
+    float h_lifetime;       // hole trapping time before irradiation (s). 0: the material's
+    float fluence;          // 1 MeV neq fluence (1/m^2)
+    float beta_e;           // electron trapping damage constant (m^2/s)
+    float beta_h;           // hole trapping damage constant (m^2/s)
+};
+
+/**
+ * @struct Injection_params
+ *
+ * "injection" section
+ */
+struct Injection_params
+{
+    float focus;                // laser focus depth (m)
+    float wavelength;           // (m)
+    float NA;                   // numerical aperture
+    float refractive_index;
+    int N;                      // carriers per pulse
+    float importance_fraction;  // share of carriers drawn in the depleted region
+};
+
+/**
+ * @struct Beam_profile_params
+ *
+ * "beam_profile" section (optional): a tabulated laser intensity that
+ * replaces the analytic gaussian beam, see beam_profile.hh. No file means
+ * the analytic beam
+ */
+struct Beam_profile_params
+{
+    std::string file;   // .npy table, 1D I(z) on axis or 2D I(r, z)
+    float z_min;        // depth of the first cell edge, relative to the focus (m)
+    float z_max;        // depth of the last cell edge, relative to the focus (m)
+    float r_max;        // outer radius of a 2D table (m)
+    bool squared;       // the table already holds the TPA rate I^2
+};
+
+/**
+ * @struct Run_params
+ *
+ * "simulation" section
+ */
+struct Run_params
+{
+    int steps;
+    float dt;               // time step (s)
+    float t_pc;             // time of the WPC sample (s)
+    std::string type;       // "visualization", "z_scan" or "sweep"
+    std::string engine;     // "stepped" or "analytic"
+    bool diffusion;
+    bool trapping;          // carriers lose weight with the detector trapping times
+    int threads;            // 0 = one per hardware thread
+    std::uint64_t seed;
+    bool waveforms;         // batch runs also stream every waveform to disk
+};
+
+/**
+ * @struct Electronics_params
+ *
+ * "electronics" section (optional): the response that turns the induced
+ * current into the filtered pulse, see electronics.hh
+ */
+struct Electronics_params
+{
+    std::string model;          // "rc", "shaper" or "measured"
+    int order;                  // integrations of the CR-RC^n shaper
+    float shaping_time;         // shaper time constant (s)
+    float gain;
+    std::string response_file;  // measured impulse response (csv of t, h)
+};
+
+/**
+ * @struct Sweep_axis
+ *
+ * one swept parameter, named "section.key" (e.g. "detector.V_bias"), and
+ * the values it takes
+ */
+struct Sweep_axis
+{
+    std::string parameter;
+    std::vector<float> values;
+};
+
+/**
+ * @struct Sweep_params
+ *
+ * "sweeps" section. The axes are combined as a Cartesian product (the last
+ * axis varies fastest) or zipped (all axes have the same length)
+ */
+struct Sweep_params
+{
+    std::string combine;            // "product" or "zip"
+    std::vector<Sweep_axis> axes;   // empty without a sweeps section
+    std::string output;             // table written by the sweep mode
+};
+
+struct Simulation_params
+{
+    Detector_params detector;
+    Injection_params injection;
+    Beam_profile_params beam_profile;
+    Run_params simulation;
+    Electronics_params electronics;
+    Sweep_params sweeps;
+};
+
+/**
+ * @class Config_error
+ *
+ * thrown when a configuration does not validate. what() holds the full
+ * report, one problem per line
+ */
+class Config_error : public std::invalid_argument
+{
+    public:
+        explicit Config_error(const std::vector<std::string>&);
+
+        inline const std::vector<std::string>& get_problems() const {return _problems;}
+
+    private:
+        std::vector<std::string> _problems;
+};
+
+Simulation_params parse_simulation_params(const nlohmann::json&);
+Detector make_detector(const Detector_params&);
+nlohmann::json to_json(const Simulation_params&);
+bool is_sweepable(const std::string&);
+void set_parameter(Simulation_params&, const std::string&, float);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _SWEEP_HH_
+#define _SWEEP_HH_
+
+/**
+ * @brief Parameter sweeps
+ * @author D. Rosich
+ *
+ * Runs the points of the sweeps section of the configuration (a Cartesian
+ * product or a zip of axes over any float parameter, see Sweep_params) and
+ * shares the work that does not change between points:
+ *   - the beam is sampled once per set of beam parameters (wavelength, NA,
+ *     refractive index, N) and translated to every focus, whatever the
+ *     detector parameters are
+ *   - the induced current is computed once per set of parameters that reach
+ *     the transport. Points that only differ in the readout (detector.R,
+ *     simulation.t_pc) reuse it and only redo the readout
+ * The transports run concurrently on a Thread_pool; the results come back in
+ * point order and do not depend on the number of threads.
+ */
+
+#include "pulse.hh"
+#include "simulation_params.hh"
+#include "thread_pool.hh"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @struct Sweep_point
+ *
+ * one point of a sweep and its pulse
+ */
+struct Sweep_point
+{
+    std::vector<float> values;  // value of each axis
+    Simulation_params params;   // base parameters with the values applied
+    Pulse pulse;
+};
+
+// receives the points of a sweep in order, see run_sweep
+using Sweep_sink = std::function<void(const Sweep_point&)>;
+
+std::vector<Sweep_point> make_sweep_points(const Simulation_params&);
+std::vector<Sweep_point> make_z_scan_points(const Simulation_params&);
+void run_sweep(std::vector<Sweep_point>&, Thread_pool&, const Sweep_sink& sink = nullptr);
+void write_sweep_table(const std::string&, const Sweep_params&, const std::vector<Sweep_point>&);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef _TCT_H_
+#define _TCT_H_
+
+/**
+ * @brief C interface of the simulation core
+ * @author D. Rosich
+ *
+ * Plain C entry points of libtct_core.so, for programs that are not C++:
+ * Python through ctypes (see python/tct.py), Julia, R... A tct_simulation
+ * holds validated parameters and a thread pool. Waveforms are written into
+ * buffers owned by the caller (NumPy arrays, for instance), one row of
+ * `steps` floats per pulse, so nothing is serialised or spawned.
+ *
+ * Every function returns 0 on success and -1 on failure, in which case
+ * tct_last_error() tells why. A handle must not be used by two threads at
+ * once; the simulation itself runs on the threads of the handle.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TCT_API __attribute__((visibility("default")))
+#else
+#define TCT_API
+#endif
+
+typedef struct tct_simulation tct_simulation;
+
+/* version of this interface */
+TCT_API int tct_api_version(void);
+
+/* directory holding exp_data/. Call before the first simulation */
+TCT_API void tct_set_project_directory(const char* dir);
+
+/* drop the field maps, readout responses, beam profiles and v(E) curves
+ * kept between simulations (the last few of each). The next simulation
+ * rebuilds what it needs */
+TCT_API void tct_clear_caches(void);
+
+/* parse and validate a configuration given as json text. Returns NULL on
+ * failure; the reason is copied to error (if not NULL) */
+TCT_API tct_simulation* tct_create(const char* config_json, char* error, size_t error_size);
+TCT_API void tct_destroy(tct_simulation* sim);
+TCT_API const char* tct_last_error(const tct_simulation* sim);
+
+/* change one float parameter, named as in the sweeps section
+ * ("detector.V_bias", "injection.focus"...) */
+TCT_API int tct_set_parameter(tct_simulation* sim, const char* name, double value);
+TCT_API int tct_get_steps(const tct_simulation* sim);
+TCT_API double tct_get_dt(const tct_simulation* sim);
+
+/* simulate one pulse focused at focus (m). Any buffer may be NULL; the
+ * waveforms hold steps floats, charge and WPC one value */
+TCT_API int tct_simulate_pulse(tct_simulation* sim, double focus, uint64_t seed,
+                               float* signal_e, float* signal_h, float* signal_total, float* filtered,
+                               double* charge, double* WPC);
+
+/* z-scan over n foci (m), sharing one beam sample between the points. Row i
+ * of signal_total and filtered (n x steps) and element i of charge and WPC
+ * belong to foci[i]. Any buffer may be NULL */
+TCT_API int tct_z_scan(tct_simulation* sim, const double* foci, size_t n,
+                       float* signal_total, float* filtered, double* charge, double* WPC);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef _THREADPOOL_HH_
+#define _THREADPOOL_HH_
+
+/**
+ * @class Thread_pool
+ * @author D. Rosich
+ *
+ * Fixed-size pool of worker threads fed from a FIFO task queue. Tasks are
+ * submitted as callables and their results are handed back through
+ * std::future, so the caller decides in which order results are gathered.
+ * parallel_for() splits an indexed loop over the pool, with the calling
+ * thread taking part.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class Thread_pool
+{
+    public:
+        explicit Thread_pool(int n_workers = 0);
+        ~Thread_pool();
+
+        Thread_pool(const Thread_pool&) = delete;
+        Thread_pool& operator=(const Thread_pool&) = delete;
+
+        inline int get_n_workers() const {return static_cast<int>(_workers.size());}
+
+        template <class F>
+        auto submit(F&& f) -> std::future<std::invoke_result_t<F>>;
+
+        void parallel_for(std::size_t, const std::function<void(std::size_t)>&);
+
+    private:
+        std::vector<std::thread> _workers;
+        std::queue<std::function<void()>> _tasks;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _stop = false;
+
+        void _worker_loop();
+};
+
+/**
+ * @brief queue a task
+ *
+ * @param f callable taking no arguments
+ *
+ * @returns future holding the value returned by f (or the exception it threw)
+ */
+template <class F>
+auto Thread_pool::submit(F&& f) -> std::future<std::invoke_result_t<F>>
+{
+    using R = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    std::future<R> result = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.emplace([task]() { (*task)(); });
+    }
+    _cv.notify_one();
+    return result;
+}
+
+#endif
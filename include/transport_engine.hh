@@ -0,0 +1,74 @@
+#ifndef _TRANSPORTENGINE_HH_
+#define _TRANSPORTENGINE_HH_
+
+/**
+ * @class Transport_engine
+ * @author D. Rosich
+ *
+ * Steps the electron and hole populations of one pulse together. Each call
+ * to step() moves both species by one time step and returns the induced
+ * current of each, so the caller only has to store the waveform.
+ *
+ * The carriers are cut into fixed-size chunks. With a Thread_pool the chunks
+ * are spread over its threads; partial currents are kept per chunk and added
+ * with a fixed-order reduction tree, so the waveform does not depend on the
+ * number of threads.
+ *
+ * Collected carriers (outside the field region, where they no longer move)
+ * are periodically compacted out of the carrier arrays; once none is left
+ * is_done() turns true and the caller can stop stepping.
+ *
+ * Diffusion is off until set_diffusion() enables it with a seed, and trapping
+ * until set_trapping() enables it.
+ */
+
+#include "charge_injection.hh"
+#include "detector.hh"
+#include "field_map.hh"
+#include "thread_pool.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @struct Step_current
+ *
+ * induced current of each species during one step (A)
+ */
+struct Step_current
+{
+    float e;
+    float h;
+};
+
+class Transport_engine
+{
+    public:
+        Transport_engine(Charge_injection&, Charge_injection&, Detector*, Thread_pool* pool = nullptr);
+        ~Transport_engine() = default;
+
+        Step_current step(float);
+        bool is_done() const;
+        void set_diffusion(bool, std::uint64_t);
+        void set_trapping(bool);
+
+    private:
+        Charge_injection* _electrons;
+        Charge_injection* _holes;
+        Detector* _det;
+        Thread_pool* _pool;
+        int _n_steps;
+        bool _diffusion;
+        bool _trapping;
+        std::uint64_t _seed;
+        std::shared_ptr<const Field_map> _field;
+        std::shared_ptr<const Field_map> _weighting;
+        Field_view _field_view;
+        Field_view _weighting_view;
+
+        std::vector<float> _partial;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _VELOCITYTABLE_HH_
+#define _VELOCITYTABLE_HH_
+
+/**
+ * @class Velocity_table
+ * @author D. Rosich
+ *
+ * Drift velocity as a function of the electric field, resampled once on a
+ * uniform field grid. A lookup is a multiply, a truncation and two loads, so
+ * the drift kernels can evaluate v(E) for every carrier and step with vector
+ * gathers instead of a binary search through the measured curve. Materials
+ * without a measured curve tabulate the Caughey-Thomas model instead.
+ */
+
+#include "carrier_store.hh"
+
+#include <vector>
+
+class Velocity_table
+{
+    public:
+        Velocity_table() = default;
+        Velocity_table(std::vector<float>, std::vector<float>, float, int n_points = 1024);
+        Velocity_table(float, float, float, float, int n_points = 1024);
+        ~Velocity_table() = default;
+
+        float operator()(float) const;
+
+        inline const float* v() const {return _v.data();}
+        inline const float* dv() const {return _dv.data();}
+        inline float get_inv_dE() const {return _inv_dE;}
+        inline float get_max_index() const {return _max_index;}
+
+    private:
+        aligned_vector _v;      // v at the grid nodes (m/s)
+        aligned_vector _dv;     // v[i+1] - v[i] (m/s)
+        float _inv_dE = 0.;     // 1/grid spacing (m/V)
+        float _max_index = 0.;  // last valid bin, as a float for the kernels
+};
+
+#endif
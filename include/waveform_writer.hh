@@ -0,0 +1,76 @@
+#ifndef _WAVEFORMWRITER_HH_
+#define _WAVEFORMWRITER_HH_
+
+/**
+ * @class Waveform_writer
+ * @author D. Rosich
+ *
+ * Streams every pulse of a scan or sweep to a directory of columns, one .npy
+ * file per quantity:
+ *   - signal_e, signal_h, signal_total, filtered: float32 (n_pulses, steps)
+ *   - focus, charge, WPC and one column per sweep axis: float32 (n_pulses,)
+ * plus a meta.json with dt, the number of steps and pulses, the column list
+ * and the full parameter block. Row i of every column belongs to the same
+ * pulse, so a single waveform or a single figure of merit is read without
+ * parsing the rest (numpy.load(..., mmap_mode="r")).
+ *
+ * The pulses are written by a background thread. append() only copies the
+ * pulse into a bounded queue and blocks when the writer falls behind, so
+ * the memory held does not grow with the number of points. A failure of
+ * the writer is rethrown by the next append() or by close().
+ */
+
+#include "npy.hh"
+#include "simulation_params.hh"
+#include "sweep.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Waveform_writer
+{
+    public:
+        Waveform_writer(const std::string&, const Simulation_params&, const std::vector<std::string>&,
+                        std::size_t max_pending = 16);
+        ~Waveform_writer();
+
+        Waveform_writer(const Waveform_writer&) = delete;
+        Waveform_writer& operator=(const Waveform_writer&) = delete;
+
+        void append(const Sweep_point&);
+        void close();
+
+        inline std::size_t get_bytes_written() const {return _bytes;}
+
+    private:
+        std::string _dir;
+        nlohmann::json _meta;
+        std::size_t _steps;
+        std::size_t _max_pending;
+        std::size_t _bytes;
+
+        std::vector<std::string> _scalar_names;
+        std::vector<std::unique_ptr<Npy_writer>> _scalars;
+        std::vector<std::unique_ptr<Npy_writer>> _waveforms;    // e, h, total, filtered
+
+        std::deque<Sweep_point> _queue;
+        std::mutex _mutex;
+        std::condition_variable _not_empty;
+        std::condition_variable _not_full;
+        bool _closing;
+        bool _closed;
+        std::exception_ptr _error;
+        std::thread _thread;
+
+        void _run();
+        void _write(const Sweep_point&);
+        void _write_meta(std::size_t, bool);
+};
+
+#endif
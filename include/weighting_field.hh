@@ -0,0 +1,27 @@
+#ifndef _WEIGHTINGFIELD_HH_
+#define _WEIGHTINGFIELD_HH_
+
+/**
+ * @brief Ramo weighting field of the readout electrode
+ * @author D. Rosich
+ *
+ * The weighting potential is 1 on the readout electrode (centred strip of
+ * width Detector::get_electrode_width() at y = 0), 0 on the rest of that
+ * plane and on the back plane at the end of the depleted region, with no
+ * flux through the sides. It is solved with the multigrid Poisson solver and
+ * differentiated into a Field_map. In the axisymmetric geometry the
+ * electrode is a disc of that diameter on a cylindrical sensor of diameter
+ * get_physical_length(), and the map holds the (r, y) plane with the signed
+ * radius along x. Maps are cached by geometry, so every pulse of a run
+ * shares one solve.
+ */
+
+#include "field_map.hh"
+
+#include <memory>
+
+class Detector;
+
+std::shared_ptr<const Field_map> weighting_field(Detector*);
+
+#endif
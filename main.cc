@@ -1,14 +1,23 @@
 #include <iostream>
+#include <memory>
 #include <vector>
-#include <random>
 #include <filesystem>
+#include <algorithm>
 
 #include "detector.hh"
+#include "beam_profile.hh"
+#include "beam_template.hh"
 #include "charge_injection.hh"
-#include "charge_carrier.hh"
+#include "transport_engine.hh"
+#include "pulse.hh"
+#include "sweep.hh"
+#include "electronics.hh"
+#include "thread_pool.hh"
 #include "config.hh"
+#include "batch.hh"
 #include "utility.hh"
 
+#ifdef TCT_WITH_ROOT
 #include <TApplication.h>
 #include <TCanvas.h>
 #include <TGraph.h>
@@ -18,41 +27,70 @@
 #include <TH2F.h>
 #include <TMultiGraph.h>
 #include <TLegend.h>
-
-#define QE 1.602e-19
+#endif
 
 int main(int argc, char** argv)
 {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path_to_config.json>" << std::endl;
+    // --batch runs without graphics, writes csv files to --output and exits.
+    // Builds without ROOT always run this way
+    std::string config_path;
+    std::string output_dir;
+    bool trace = false;
+#ifdef TCT_WITH_ROOT
+    bool batch = false;
+#else
+    bool batch = true;
+#endif
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--batch") batch = true;
+        else if (arg == "--trace") trace = true;
+        else if (arg == "--output" && i + 1 < argc) output_dir = argv[++i];
+        else if (config_path.empty() && arg.rfind("--", 0) != 0) config_path = arg;
+        else {
+            std::cerr << "Unrecognised argument " << arg << std::endl;
+            config_path.clear();
+            break;
+        }
+    }
+    if (config_path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <path_to_config.json> [--batch] [--output <dir>] [--trace]" << std::endl;
         return 1;
     }
-    std::string config_path = argv[1];
     std::filesystem::path cwd = std::filesystem::current_path().parent_path();
-    Config cfg(cwd.string() + "/"  + config_path);
+    if (output_dir.empty()) output_dir = cwd.string();
+
+    // the whole configuration is validated before anything is set up
+    Simulation_params par;
+    try {
+        Config cfg(cwd.string() + "/"  + config_path);
+        par = cfg.get_params();
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
-    std::default_random_engine generator;
-    std::normal_distribution<float> gaussian(0.0, 1.0);
+    // sweeps only produce a table
+    if (batch || par.simulation.type == "sweep")
+        return run_batch(par, output_dir, trace);
 
+#ifdef TCT_WITH_ROOT
     TApplication app("", nullptr, nullptr);
 
-    Detector det(cfg.get_Nd(), cfg.get_width(), cfg.get_length(), 
-                 cfg.get_V_bi(), cfg.get_V_bias(), cfg.get_R(), 
-                 cfg.get_material());
+    Detector det = make_detector(par.detector);
 
-    int steps = cfg.get_steps();
-    float dt = cfg.get_dt();
-    float R = det.get_resistance();
-    float C = 1.6111e-12;
+    int steps = par.simulation.steps;
+    float dt = par.simulation.dt;
     std::vector<float> t(steps);
     std::vector<float> signal_e(steps, 0.0f);
     std::vector<float> signal_h(steps, 0.0f);
     std::vector<float> signal_total(steps, 0.0f);
     std::vector<float> filtered_pulse;
     for(int i = 0; i < steps; ++i) t[i] = i * dt;
-    float x_lim = (det.get_depleted_width() > det.get_physical_width()) ? det.get_physical_width() : det.get_depleted_width();
 
-    if(cfg.get_sim_type() == "visualization")
+    if(par.simulation.type == "visualization")
     {
         TGraph* graph_e = new TGraph();
         TGraph* graph_h = new TGraph();
@@ -66,54 +104,46 @@ int main(int argc, char** argv)
         TCanvas* c = new TCanvas("c", "Particle Motion", 800, 600);
         gStyle->SetOptStat(0);
 
-        Charge_injection injection_e(cfg.get_focus(),
-                                     cfg.get_wavelength(),
-                                     cfg.get_NA(),
-                                     cfg.get_refractive_index(),
-                                     &det,
-                                     0,
-                                     cfg.get_N());
+        // the carriers are drawn from the beam profile if there is one, as
+        // simulate_pulse does
+        std::uint64_t seed = derive_seed(par.simulation.seed, 0);
+        std::shared_ptr<const Beam_profile> profile = beam_profile(par);
+        Charge_injection injection_e = profile
+            ? Charge_injection(Beam_template(*profile, par.injection.N, seed), par.injection.focus, &det, 0)
+            : Charge_injection(par.injection.focus,
+                               par.injection.wavelength,
+                               par.injection.NA,
+                               par.injection.refractive_index,
+                               &det,
+                               0,
+                               par.injection.N,
+                               seed,
+                               par.injection.importance_fraction);
         Charge_injection injection_h = injection_e;
         injection_h.set_type(1);
+        Thread_pool pool(par.simulation.threads);
+        Transport_engine engine(injection_e, injection_h, &det, &pool);
+        engine.set_diffusion(par.simulation.diffusion, seed);
+        engine.set_trapping(par.simulation.trapping);
 
-        for(int step = 0; step < cfg.get_steps(); ++step)
+        for(int step = 0; step < steps && !engine.is_done(); ++step)
         {
             std::cout << "Processing: " << step << " th step" << std::endl;
 
-            injection_e.update_speeds();
-            injection_h.update_speeds();
+            Step_current current = engine.step(dt);
+            signal_e[step] = current.e;
+            signal_h[step] = current.h;
+            signal_total[step] = (signal_e[step] + signal_h[step]);
 
             auto& charges_e = injection_e.get_charges();
             auto& charges_h = injection_h.get_charges();
-
-            for(size_t j = 0; j < charges_e.size(); ++j)
-            {
-                auto vel_e = charges_e[j].get_velocity();
-                charges_e[j].set_position(cfg.get_dt()*vel_e.first, cfg.get_dt()*vel_e.second);
-
-                auto vel_h = charges_h[j].get_velocity();
-                charges_h[j].set_position(-cfg.get_dt()*vel_h.first, -cfg.get_dt()*vel_h.second);
-            }
-
-            float sum_e = 0.;
-            float sum_h = 0.;
-            for(size_t j = 0; j < charges_e.size(); j++)
-            {
-                sum_e += charges_e[j].get_velocity().second;
-                sum_h += charges_h[j].get_velocity().second;
-            }
-            signal_e[step] = sum_e * QE / x_lim;
-            signal_h[step] = sum_h * QE / x_lim;
-            signal_total[step] = (signal_e[step] + signal_h[step]);
-
             graph_e->Set(0);
             graph_h->Set(0);
-            for (size_t j = 0; j < charges_e.size(); ++j) {
-                auto pos_e = charges_e[j].get_position();
-                auto pos_h = charges_h[j].get_position();
-                graph_e->SetPoint(j, pos_e.first, pos_e.second);
-                graph_h->SetPoint(j, pos_h.first, pos_h.second);
-            }
+            // collected carriers are dropped, so both species can differ in size
+            for (size_t j = 0; j < charges_e.size(); ++j)
+                graph_e->SetPoint(j, charges_e.x()[j], charges_e.y()[j]);
+            for (size_t j = 0; j < charges_h.size(); ++j)
+                graph_h->SetPoint(j, charges_h.x()[j], charges_h.y()[j]);
 
             c->cd();
             graph_e->Draw("AP");
@@ -126,19 +156,8 @@ int main(int argc, char** argv)
             gSystem->Sleep(30);
         }
 
-        if(R > 0)
-        {
-            float alpha = dt / (R*C + dt);
-            filtered_pulse.push_back(alpha * signal_total[0]);
-            for (size_t i = 1; i < signal_total.size(); ++i) 
-            {
-                filtered_pulse.push_back(alpha * signal_total.at(i) + (1 - alpha) * filtered_pulse[i - 1]);
-            }
-        }
-        else
-        {
-            filtered_pulse = signal_e;
-        }
+        filtered_pulse.resize(steps);
+        electronics_response(par)->apply(signal_total.data(), filtered_pulse.data(), steps);
         TCanvas* c_pulse = new TCanvas("c_pulse", "pulse", 800, 600);
         c_pulse->cd();
         TGraph* gr_pulse_e = new TGraph(t.size(), t.data(), signal_e.data());
@@ -160,82 +179,26 @@ int main(int argc, char** argv)
         // std::cout << Q_t << std::endl;
         
     }
-    else if(cfg.get_sim_type() == "z_scan")
+    else if(par.simulation.type == "z_scan")
     {
-        std::vector<float> z_array(50);
-        for(int i = 0; i < 50; ++i)
-            z_array[i] = -20.e-6 + i*90.e-6/50;
-
-        std::vector<float> int_charge_e;
-        std::vector<float> int_charge_h;
         std::vector<float> int_charge_t;
         std::vector<float> WPC;
 
-        for(auto z : z_array)
-        {
-            std::cout << "=== SIMULATING z = " << z/1.e-6 << std::endl;
-
-            Charge_injection injection_e(z,
-                                         cfg.get_wavelength(),
-                                         cfg.get_NA(),
-                                         cfg.get_refractive_index(),
-                                         &det,
-                                         0,
-                                         cfg.get_N());
-            Charge_injection injection_h = injection_e;
-            injection_h.set_type(1);
-            
-            signal_e.resize(steps, 0.0f);
-            signal_h.resize(steps, 0.0f);
-            signal_total.resize(steps, 0.0f);
-            filtered_pulse.clear();
-            for(int step = 0; step < cfg.get_steps(); ++step)
-            {
-                injection_e.update_speeds();
-                injection_h.update_speeds();
+        // a z-scan is a sweep of the focus: the beam is sampled once and
+        // translated to every z, and the points run on the pool
+        std::vector<Sweep_point> points = make_z_scan_points(par);
+        Thread_pool pool(par.simulation.threads);
+        std::cout << "=== Scanning " << points.size() << " points on "
+                  << pool.get_n_workers() << " threads" << std::endl;
+        run_sweep(points, pool);
 
-                auto& charges_e = injection_e.get_charges();
-                auto& charges_h = injection_h.get_charges();
-
-                for(size_t j = 0; j < charges_e.size(); ++j)
-                {
-                    auto vel_e = injection_e.get_charges()[j].get_velocity();
-                    charges_e[j].set_position(cfg.get_dt()*vel_e.first, cfg.get_dt()*vel_e.second);
-
-                    auto vel_h = injection_h.get_charges()[j].get_velocity();
-                    charges_h[j].set_position(-cfg.get_dt()*vel_h.first, -cfg.get_dt()*vel_h.second);
-                }
-
-                float sum_e = 0.;
-                float sum_h = 0.;
-                for(size_t j = 0; j < charges_e.size(); j++)
-                {
-                    sum_e += injection_e.get_charges()[j].get_velocity().second;
-                    sum_h += injection_h.get_charges()[j].get_velocity().second;
-                }
-
-                signal_e[step] = sum_e * QE / x_lim;
-                signal_h[step] = sum_h * QE / x_lim;
-                signal_total[step] = (signal_e[step] + signal_h[step]);
-            }
-
-            if(R > 0)
-            {
-                float alpha = dt / (R*C + dt);
-                filtered_pulse.resize(signal_total.size());
-                filtered_pulse[0] = alpha * signal_total[0];
-                for (size_t i = 1; i < signal_total.size(); ++i) 
-                    filtered_pulse[i] = alpha * signal_total[i] + (1 - alpha) * filtered_pulse[i - 1];
-            }
-
-            float Q_t = 0.0;
-            for (int i = 1;i < steps; ++i)
-            {
-                Q_t += 0.5*(float(signal_total[i])+float(signal_total[i-1]))*dt;
-            }
-            float WPC_val = linear_interpolation(cfg.get_t_pc(), t, filtered_pulse);
-            int_charge_t.push_back(Q_t);
-            WPC.push_back(WPC_val);
+        std::vector<float> z_array;
+        for(const Sweep_point& point : points)
+        {
+            std::cout << "=== SIMULATED z = " << point.pulse.focus/1.e-6 << std::endl;
+            z_array.push_back(point.pulse.focus);
+            int_charge_t.push_back(point.pulse.charge);
+            WPC.push_back(point.pulse.WPC);
         }
 
         float max = *std::max_element(int_charge_t.begin(), int_charge_t.end());
@@ -262,5 +225,6 @@ int main(int argc, char** argv)
     }
 
     app.Run();
+#endif
     return 0;
 }
@@ -0,0 +1,65 @@
+"""
+Export a focal volume of z_scan_3D_vectorial.py as a beam profile table.
+
+z_scan_3D_vectorial.py saves the TPA density |E|^4 of every surface position
+as gaussianbeam_z=<surface>.npy, an (N, N, N) array over its x0, y0, z0 grid
+(in um) with the beam along the last axis. This script averages it in rings
+around the beam axis and writes the I^2(r, z) table read by the beam_profile
+section of the simulation:
+
+    python export_beam_profile.py gaussianbeam_z=-20.0.npy profile.npy
+
+The table has shape (n_r, n_z), z the last (fastest) axis, ascending in the
+direction of the beam (deeper into the sensor) and relative to the TPA
+maximum, which is taken as the focus. The beam_profile section that reads it
+is printed. Pass --xy and --z if the grid of z_scan_3D_vectorial.py was
+changed.
+"""
+
+import argparse
+import json
+
+import numpy as np
+
+parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+parser.add_argument("volume", help="gaussianbeam_z=*.npy of z_scan_3D_vectorial.py")
+parser.add_argument("output", help="beam profile table (.npy)")
+parser.add_argument("--xy", type=float, default=25., help="half width of the x0 and y0 grids (um)")
+parser.add_argument("--z", type=float, nargs=2, default=(-100., 100.), metavar=("Z_FIRST", "Z_LAST"),
+                    help="first and last value of the z0 grid (um)")
+args = parser.parse_args()
+
+tpa = np.load(args.volume, mmap_mode="r")
+if tpa.ndim != 3:
+    raise SystemExit(f"{args.volume}: expected an (x, y, z) volume, got shape {tpa.shape}")
+nx, ny, nz = tpa.shape
+x = np.linspace(-args.xy, args.xy, nx)
+y = np.linspace(-args.xy, args.xy, ny)
+z = np.linspace(args.z[0], args.z[1], nz)
+if z[0] > z[-1]:
+    # the table runs along the beam
+    tpa, z = tpa[:, :, ::-1], z[::-1]
+dr = x[1] - x[0]
+dz = z[1] - z[0]
+
+# beam axis and focus at the TPA maximum, as z_scan_3D_vectorial.py finds them
+ix, iy, iz = np.unravel_index(np.argmax(tpa), tpa.shape)
+r = np.hypot(*np.meshgrid(x - x[ix], y - y[iy], indexing="ij"))
+
+# only complete rings, so every radius is averaged over the whole circle
+n_r = int(min(x[ix] - x[0], x[-1] - x[ix], y[iy] - y[0], y[-1] - y[iy])/dr)
+ring = (r/dr).astype(int)
+profile = np.empty((n_r, nz))
+for k in range(n_r):
+    profile[k] = tpa[ring == k].mean(axis=0)
+np.save(args.output, profile)
+
+# the table values stand for cells: the grid bounds are half a step outside
+# the first and last sample. Lengths in m
+um = 1e-6
+section = {"file": args.output,
+           "z_min": float((z[0] - z[iz] - dz/2)*um),
+           "z_max": float((z[-1] - z[iz] + dz/2)*um),
+           "r_max": float(n_r*dr*um),
+           "squared": True}
+print(json.dumps({"beam_profile": section}, indent=4))
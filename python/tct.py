@@ -0,0 +1,141 @@
+"""
+Python bindings of the simulation core (include/tct.h) through ctypes.
+
+The waveforms are written by the library straight into NumPy arrays, so a
+call costs the simulation and nothing else:
+
+    import tct
+    sim = tct.Simulation("config.json")
+    sim.set("detector.V_bias", 150)
+    pulse = sim.pulse(focus=20e-6)
+    scan = sim.z_scan(np.linspace(-20e-6, 70e-6, 50))
+
+The library is looked for in $TCT_LIBRARY, then in build/ next to this
+directory. Data files (exp_data/) are read from the project directory, the
+parent of this one unless given.
+"""
+
+import ctypes
+import json
+import os
+
+import numpy as np
+
+_HERE = os.path.dirname(os.path.abspath(__file__))
+_PROJECT = os.path.dirname(_HERE)
+
+
+def _load(path=None):
+    path = path or os.environ.get("TCT_LIBRARY") or os.path.join(_PROJECT, "build", "libtct_core.so")
+    lib = ctypes.CDLL(path)
+    handle = ctypes.c_void_p
+    lib.tct_api_version.restype = ctypes.c_int
+    if lib.tct_api_version() != 2:
+        raise RuntimeError("unsupported libtct_core version")
+    lib.tct_set_project_directory.argtypes = [ctypes.c_char_p]
+    lib.tct_clear_caches.restype = None
+    lib.tct_create.restype = handle
+    lib.tct_create.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t]
+    lib.tct_destroy.argtypes = [handle]
+    lib.tct_last_error.restype = ctypes.c_char_p
+    lib.tct_last_error.argtypes = [handle]
+    lib.tct_set_parameter.argtypes = [handle, ctypes.c_char_p, ctypes.c_double]
+    lib.tct_get_steps.argtypes = [handle]
+    lib.tct_get_dt.restype = ctypes.c_double
+    lib.tct_get_dt.argtypes = [handle]
+    # buffers are passed as void* so that None gives NULL
+    lib.tct_simulate_pulse.argtypes = [handle, ctypes.c_double, ctypes.c_uint64] + [ctypes.c_void_p]*6
+    lib.tct_z_scan.argtypes = [handle, ctypes.c_void_p, ctypes.c_size_t] + [ctypes.c_void_p]*4
+    return lib
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        _lib = _load()
+        _lib.tct_set_project_directory(_PROJECT.encode())
+    return _lib
+
+
+def _ptr(a):
+    return None if a is None else a.ctypes.data
+
+
+def clear_caches():
+    """Drop the field maps, responses and beam profiles kept between simulations."""
+    _library().tct_clear_caches()
+
+
+class Simulation:
+    """Validated parameters and the threads that simulate them."""
+
+    def __init__(self, config, project_directory=None):
+        """config: path of a json file, json text or a dict."""
+        lib = _library()
+        if project_directory is not None:
+            lib.tct_set_project_directory(os.fspath(project_directory).encode())
+        if isinstance(config, dict):
+            text = json.dumps(config)
+        elif isinstance(config, str) and config.lstrip().startswith("{"):
+            text = config
+        else:
+            with open(config) as f:
+                text = f.read()
+        error = ctypes.create_string_buffer(1024)
+        self._lib = lib
+        self._handle = lib.tct_create(text.encode(), error, len(error))
+        if not self._handle:
+            raise ValueError(error.value.decode())
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self._lib.tct_destroy(self._handle)
+            self._handle = None
+
+    def _check(self, status):
+        if status != 0:
+            raise RuntimeError(self._lib.tct_last_error(self._handle).decode())
+
+    @property
+    def steps(self):
+        return self._lib.tct_get_steps(self._handle)
+
+    @property
+    def dt(self):
+        return self._lib.tct_get_dt(self._handle)
+
+    def time(self):
+        return np.arange(self.steps)*self.dt
+
+    def set(self, name, value):
+        """Change one parameter, named as in the sweeps section."""
+        self._check(self._lib.tct_set_parameter(self._handle, name.encode(), float(value)))
+
+    def pulse(self, focus, seed=0):
+        """One pulse. Returns a dict of waveforms (A) and figures of merit."""
+        out = {k: np.empty(self.steps, np.float32) for k in ("signal_e", "signal_h", "signal_total", "filtered")}
+        charge = np.zeros(1)
+        WPC = np.zeros(1)
+        self._check(self._lib.tct_simulate_pulse(self._handle, float(focus), seed,
+                                                 _ptr(out["signal_e"]), _ptr(out["signal_h"]),
+                                                 _ptr(out["signal_total"]), _ptr(out["filtered"]),
+                                                 _ptr(charge), _ptr(WPC)))
+        out["charge"] = charge[0]
+        out["WPC"] = WPC[0]
+        return out
+
+    def z_scan(self, foci, waveforms=True):
+        """A z-scan. Waveforms are (len(foci), steps) arrays."""
+        foci = np.ascontiguousarray(foci, np.float64)
+        n = len(foci)
+        out = {"focus": foci, "charge": np.zeros(n), "WPC": np.zeros(n)}
+        if waveforms:
+            out["signal_total"] = np.empty((n, self.steps), np.float32)
+            out["filtered"] = np.empty((n, self.steps), np.float32)
+        self._check(self._lib.tct_z_scan(self._handle, _ptr(foci), n,
+                                         _ptr(out.get("signal_total")), _ptr(out.get("filtered")),
+                                         _ptr(out["charge"]), _ptr(out["WPC"])))
+        return out
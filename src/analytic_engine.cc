@@ -0,0 +1,170 @@
+#include "analytic_engine.hh"
+#include "drift_kernel.hh"
+#include "electric_field.hh"
+#include "profiler.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#define QE 1.602e-19
+
+// nodes of the depth grid on which the time to collection is integrated
+static constexpr int N_DEPTH = 4096;
+
+/**
+ * @brief class constructor
+ *
+ * @param electrons electron injection. Its carriers are only read
+ * @param holes hole injection. Its carriers are only read
+ * @param det detector geometry
+ */
+Analytic_engine::Analytic_engine(Charge_injection& electrons, Charge_injection& holes, Detector* det)
+{
+    // the time-shift argument needs the induced charge to depend on depth
+    // only, i.e. the uniform weighting field of a pad electrode
+    if (det->get_electrode_width() < det->get_physical_length())
+        throw std::invalid_argument("Analytic_engine: segmented electrodes need the stepped engine");
+
+    _electrons = &electrons;
+    _holes = &holes;
+    _det = det;
+    _trapping = false;
+}
+
+/**
+ * @brief switch trapping on or off
+ *
+ * @param trapping true to let the carriers be trapped, with the same decay
+ *        per step as Transport_engine
+ */
+void Analytic_engine::set_trapping(bool trapping)
+{
+    _trapping = trapping;
+}
+
+/**
+ * @brief induced current of both species
+ *
+ * fills the waveforms that Transport_engine would produce in the given number
+ * of steps. Diffusion is not included
+ *
+ * @param dt time step (s)
+ * @param steps number of time bins
+ * @param signal_e electron induced current per bin (A)
+ * @param signal_h hole induced current per bin (A)
+ */
+void Analytic_engine::run(float dt, int steps, std::vector<float>& signal_e, std::vector<float>& signal_h)
+{
+    TCT_PROFILE_SCOPE("transport.analytic");
+    signal_e = _species_current(*_electrons, 0, dt, steps);
+    signal_h = _species_current(*_holes, 1, dt, steps);
+}
+
+/**
+ * @brief induced current of one species
+ *
+ * with d the distance to the collecting electrode (y_max - y for electrons,
+ * y for holes), the time left to collection is s(d) = int_0^d dd'/v(d'). The
+ * inverse, R(s), is the distance still to travel after s more seconds in the
+ * field, so a carrier starting at s_i travels R(s_i - k dt) - R(s_i - (k+1) dt)
+ * during step k. The carriers are deposited on a histogram of s with spacing
+ * dt (linear weights between the two closest bins) and the current of step k
+ * is the correlation of that histogram with the increments of R, times the
+ * weight left after k steps of trapping. The cost is one pass over the
+ * carriers plus steps x (transit time / dt)
+ *
+ * @param injection carriers of the species
+ * @param type carrier type. 0->electrons, 1->holes
+ * @param dt time step (s)
+ * @param steps number of time bins
+ *
+ * @returns induced current per bin (A)
+ */
+std::vector<float> Analytic_engine::_species_current(Charge_injection& injection, int type, float dt, int steps)
+{
+    std::vector<float> current(steps, 0.);
+    Drift_params p = make_drift_params(_det, injection.get_velocity_table(), type, dt);
+    const Velocity_table& table = injection.get_velocity_table();
+    // the field of both models only depends on depth (uniform doping)
+    std::shared_ptr<const Field_map> field = electric_field(_det);
+
+    // time to collection on a uniform depth grid (trapezoidal rule on 1/v).
+    // Where v(E) vanishes (the depletion edge of a partially depleted sensor
+    // for a Caughey-Thomas material) the cell next to it takes the midpoint
+    // rule instead, so s(d) stays finite. Beyond a cell without any drift
+    // the carriers are never collected and induce no current
+    double dd = p.y_max/(N_DEPTH - 1);
+    std::vector<double> s(N_DEPTH, 0.);
+    auto inv_v = [&](double d)
+    {
+        double y = type == 0 ? p.y_max - d : d;
+        float Ex, Ey;
+        field->sample(0., y, Ex, Ey);
+        float v = table(Ey);
+        return v > 0. ? 1./v : HUGE_VAL;
+    };
+    int n_last = N_DEPTH - 1;
+    double prev = inv_v(0.);
+    for (int n = 1; n < N_DEPTH; ++n)
+    {
+        double cur = inv_v(n*dd);
+        double cell = std::isfinite(prev) && std::isfinite(cur) ? 0.5*(prev + cur)*dd
+                                                                : inv_v((n - 0.5)*dd)*dd;
+        if (!std::isfinite(cell))
+        {
+            n_last = n - 1;
+            break;
+        }
+        s[n] = s[n-1] + cell;
+        prev = cur;
+    }
+
+    // histogram of the time to collection, in units of dt
+    Carrier_store& charges = injection.get_charges();
+    const float* x = charges.x();
+    const float* y = charges.y();
+    const float* w = charges.weight();
+    int n_bins = static_cast<int>(std::ceil(s[n_last]/dt)) + 2;
+    std::vector<double> hist(n_bins, 0.);
+    double d_last = n_last*dd;
+    for (std::size_t i = 0; i < charges.size(); ++i)
+    {
+        if (y[i] < 0. || y[i] > p.y_max || x[i] < -p.x_half || x[i] > p.x_half)
+            continue;
+        double d = type == 0 ? p.y_max - y[i] : y[i];
+        if (n_last < N_DEPTH - 1 && d > d_last)
+            continue;
+        double f = std::min(d/dd, double(n_last));
+        int n = std::min(static_cast<int>(f), std::max(n_last - 1, 0));
+        double t = n_last > 0 ? (s[n] + (f - n)*(s[n+1] - s[n]))/dt : 0.;
+        int j = std::min(static_cast<int>(t), n_bins - 2);
+        hist[j] += w[i]*(1. - (t - j));
+        hist[j+1] += w[i]*(t - j);
+    }
+
+    // R at s = m*dt, inverting s(d) with a merge walk over both grids
+    std::vector<double> R(n_bins, 0.);
+    int n = 0;
+    for (int m = 1; m < n_bins && n_last > 0; ++m)
+    {
+        double target = m*dt;
+        while (n < n_last - 1 && s[n+1] < target) ++n;
+        double frac = std::clamp((target - s[n])/(s[n+1] - s[n]), 0., 1.);
+        R[m] = (n + frac)*dd;
+    }
+
+    // step k collects, from the carriers in bin j, R[j-k] - R[j-k-1]
+    double scale = QE/(p.y_max*dt);
+    double decay = _trapping ? p.decay : 1.;
+    double alive = 1.;
+    for (int k = 0; k < steps; ++k)
+    {
+        double sum = 0.;
+        for (int j = k + 1; j < n_bins; ++j)
+            sum += hist[j]*(R[j-k] - R[j-k-1]);
+        current[k] = sum*scale*alive;
+        alive *= decay;
+    }
+    return current;
+}
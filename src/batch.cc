@@ -0,0 +1,164 @@
+#include "batch.hh"
+#include "detector.hh"
+#include "profiler.hh"
+#include "pulse.hh"
+#include "sweep.hh"
+#include "thread_pool.hh"
+#include "waveform_writer.hh"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+/**
+ * @brief write the waveforms of a pulse
+ *
+ * one line per time step: t, electron, hole and total current and the
+ * filtered pulse
+ */
+static void _write_pulse(const std::string& path, const Pulse& pulse, float dt)
+{
+    TCT_PROFILE_SCOPE("output.csv");
+    std::ofstream out(path);
+    if (!out.is_open()) throw std::runtime_error("Could not open output file: " + path);
+    out << "t,signal_e,signal_h,signal_total,filtered\n";
+    out.precision(9);
+    for (std::size_t i = 0; i < pulse.signal_total.size(); ++i)
+        out << i*dt << "," << pulse.signal_e[i] << "," << pulse.signal_h[i] << ","
+            << pulse.signal_total[i] << "," << pulse.filtered[i] << "\n";
+    TCT_PROFILE_COUNT("output.bytes", static_cast<double>(out.tellp()));
+}
+
+/**
+ * @brief write the result of a z-scan
+ *
+ * one line per focus: focus, charge and WPC
+ */
+static void _write_z_scan(const std::string& path, const std::vector<Sweep_point>& points)
+{
+    TCT_PROFILE_SCOPE("output.csv");
+    std::ofstream out(path);
+    if (!out.is_open()) throw std::runtime_error("Could not open output file: " + path);
+    out << "focus,charge,WPC\n";
+    out.precision(9);
+    for (const Sweep_point& pt : points)
+        out << pt.pulse.focus << "," << pt.pulse.charge << "," << pt.pulse.WPC << "\n";
+    TCT_PROFILE_COUNT("output.bytes", static_cast<double>(out.tellp()));
+}
+
+#ifdef TCT_PROFILING
+/**
+ * @brief write the run report
+ *
+ * the phases and counters recorded during the run plus the figures derived
+ * from them: injection acceptance (carriers kept in the simulation window
+ * over carriers sampled), carrier-steps and their rate, mean active carriers
+ * per step and bytes written
+ *
+ * @param path output file
+ * @param wall_time duration of the run (s)
+ */
+static void _write_report(const std::string& path, double wall_time)
+{
+    nlohmann::json report = profile_report();
+    auto value = [&report](const char* group, const char* name, const char* field)
+    {
+        const nlohmann::json& g = report[group];
+        return g.contains(name) ? g[name][field].get<double>() : 0.;
+    };
+    double sampled = value("counters", "injection.sampled", "sum");
+    double carrier_steps = value("counters", "transport.active_carriers", "sum");
+    double step_time = value("phases", "transport.step", "total_s");
+    report["wall_time_s"] = wall_time;
+    report["derived"] = {
+        {"injection_acceptance", sampled > 0. ? value("counters", "injection.kept", "sum")/sampled : 0.},
+        {"carrier_steps", carrier_steps},
+        {"mean_active_carriers", value("counters", "transport.active_carriers", "mean")},
+        {"carrier_steps_per_s", step_time > 0. ? carrier_steps/step_time : 0.},
+        {"carrier_steps_per_wall_s", wall_time > 0. ? carrier_steps/wall_time : 0.},
+        {"bytes_written", value("counters", "output.bytes", "sum")}
+    };
+    std::ofstream out(path);
+    if (!out.is_open()) throw std::runtime_error("Could not open output file: " + path);
+    out << report.dump(4) << "\n";
+}
+#endif
+
+/**
+ * @brief run a configuration without graphics
+ *
+ * @param par simulation parameters
+ * @param output_dir directory of the result files. Created if missing
+ * @param trace also write a Chrome trace of the run (trace.json). Builds
+ *              with TCT_PROFILING always write the run report (profile.json)
+ *
+ * @returns 0 on success, 2 if the simulation or the output failed
+ */
+int run_batch(const Simulation_params& par, const std::string& output_dir, bool trace)
+{
+#ifdef TCT_PROFILING
+    auto start = std::chrono::steady_clock::now();
+    profile_reset();
+    profile_enable_trace(trace);
+#else
+    if (trace)
+        std::cerr << "--trace needs a build with TCT_PROFILING, no trace written" << std::endl;
+#endif
+    try {
+        std::filesystem::create_directories(output_dir);
+        Thread_pool pool(par.simulation.threads);
+        std::string output;
+        if (par.simulation.type == "visualization")
+        {
+            Detector det = make_detector(par.detector);
+            Pulse pulse = simulate_pulse(par.injection.focus, par, &det, derive_seed(par.simulation.seed, 0), &pool);
+            output = output_dir + "/pulse.csv";
+            _write_pulse(output, pulse, par.simulation.dt);
+        }
+        else
+        {
+            bool z_scan = par.simulation.type == "z_scan";
+            std::vector<Sweep_point> points = z_scan ? make_z_scan_points(par) : make_sweep_points(par);
+            std::cout << "=== Running " << points.size() << " points on "
+                      << pool.get_n_workers() << " threads" << std::endl;
+            if (par.simulation.waveforms)
+            {
+                // every waveform goes to disk as soon as its point is done
+                std::vector<std::string> axes;
+                if (!z_scan)
+                    for (const Sweep_axis& axis : par.sweeps.axes) axes.push_back(axis.parameter);
+                std::string dir = output_dir + "/waveforms";
+                Waveform_writer writer(dir, par, axes);
+                run_sweep(points, pool, [&writer](const Sweep_point& pt) {writer.append(pt);});
+                writer.close();
+                std::cout << "=== " << writer.get_bytes_written() << " bytes of waveforms written to "
+                          << dir << std::endl;
+            }
+            else
+                run_sweep(points, pool);
+            output = output_dir + "/" + (z_scan ? std::string("z_scan.csv") : par.sweeps.output);
+            if (z_scan)
+                _write_z_scan(output, points);
+            else
+                write_sweep_table(output, par.sweeps, points);
+        }
+        std::cout << "=== Results written to " << output << std::endl;
+#ifdef TCT_PROFILING
+        double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        _write_report(output_dir + "/profile.json", wall_time);
+        std::cout << "=== Profile written to " << output_dir << "/profile.json" << std::endl;
+        if (trace)
+        {
+            write_profile_trace(output_dir + "/trace.json");
+            std::cout << "=== Trace written to " << output_dir << "/trace.json" << std::endl;
+        }
+#endif
+    }
+    catch (const std::exception& e) {
+        std::cerr << "run failed: " << e.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
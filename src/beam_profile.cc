@@ -0,0 +1,156 @@
+#include "beam_profile.hh"
+#include "npy.hh"
+#include "profiler.hh"
+#include "resource_cache.hh"
+#include "utility.hh"
+
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief class constructor
+ *
+ * reads the table through a memory map, turns it into the carrier count of
+ * every cell and builds the alias table (Vose's method, O(cells))
+ *
+ * @param path .npy table
+ * @param p beam_profile section (grid and whether the table is squared)
+ * @param wavelength laser wavelength (m), for the waist of an on-axis table
+ * @param numerical_aperture laser numerical aperture
+ * @param refractive_index detector material refractive index
+ * @param axisymmetric fill the 3D focal volume of a cylindrical sensor
+ *
+ * @throws std::runtime_error if the table cannot be read, is not 1D or 2D,
+ *         holds negative values or no intensity at all
+ */
+Beam_profile::Beam_profile(const std::string& path,
+                           const Beam_profile_params& p,
+                           float wavelength,
+                           float numerical_aperture,
+                           float refractive_index,
+                           bool axisymmetric)
+{
+    TCT_PROFILE_SCOPE("injection.beam_profile");
+    _wavelength = wavelength;
+    _numerical_aperture = numerical_aperture;
+    _refractive_index = refractive_index;
+    _axisymmetric = axisymmetric;
+
+    Npy_array table(path);
+    const std::vector<std::size_t>& shape = table.get_shape();
+    if (shape.size() == 1)
+    {
+        _n_r = 1;
+        _n_z = shape[0];
+    }
+    else if (shape.size() == 2)
+    {
+        _n_r = shape[0];
+        _n_z = shape[1];
+        if (!(p.r_max > 0.)) throw std::runtime_error(path + ": a 2D beam profile needs beam_profile.r_max");
+    }
+    else
+        throw std::runtime_error(path + ": a beam profile must be a 1D or 2D table");
+    if (table.size() == 0) throw std::runtime_error(path + ": empty beam profile");
+    if (table.size() > UINT32_MAX) throw std::runtime_error(path + ": beam profile too large");
+    _z_min = p.z_min;
+    _dz = (p.z_max - p.z_min)/_n_z;
+    _dr = p.r_max/_n_r;
+
+    // intensity of every cell
+    std::vector<double> I(table.size());
+    for (std::size_t k = 0; k < I.size(); ++k)
+    {
+        double v = table[k];
+        if (!(v >= 0.) || std::isinf(v)) throw std::runtime_error(path + ": negative or invalid intensity");
+        I[k] = p.squared ? std::sqrt(v) : v;
+    }
+
+    // carriers per cell, up to a constant: I^2 times the cell area, or its
+    // volume in 3D. On axis the transverse gaussian integrates to
+    // sqrt(pi/8) w along a line and pi w^2/4 over the plane, with w^2 I fixed
+    std::vector<double> weight(I.size());
+    if (_n_r == 1)
+    {
+        double w0 = wavelength/(M_PI*numerical_aperture);
+        double I_max = *std::max_element(I.begin(), I.end());
+        _sigma.assign(_n_z, 0.);
+        for (std::size_t iz = 0; iz < _n_z; ++iz)
+        {
+            if (I[iz] <= 0.) continue;
+            double w2 = w0*w0*I_max/I[iz];
+            _sigma[iz] = std::sqrt(w2/8.);
+            weight[iz] = I[iz]*I[iz]*(axisymmetric ? w2 : std::sqrt(w2));
+        }
+    }
+    else
+        for (std::size_t k = 0; k < I.size(); ++k)
+            weight[k] = I[k]*I[k]*(axisymmetric ? 2.*(k/_n_z) + 1. : 1.);
+
+    double total = 0.;
+    for (double w : weight) total += w;
+    if (!(total > 0.) || std::isinf(total)) throw std::runtime_error(path + ": beam profile without intensity");
+
+    // alias table: cells below the mean are topped up from cells above it
+    std::size_t n = weight.size();
+    std::vector<double> scaled(n);
+    std::vector<std::uint32_t> small, large;
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        scaled[k] = weight[k]*n/total;
+        (scaled[k] < 1. ? small : large).push_back(static_cast<std::uint32_t>(k));
+    }
+    _probability.assign(n, 1.);
+    _alias.resize(n);
+    for (std::size_t k = 0; k < n; ++k) _alias[k] = static_cast<std::uint32_t>(k);
+    while (!small.empty() && !large.empty())
+    {
+        std::uint32_t s = small.back();
+        small.pop_back();
+        std::uint32_t l = large.back();
+        _probability[s] = static_cast<float>(scaled[s]);
+        _alias[s] = l;
+        scaled[l] -= 1. - scaled[s];
+        if (scaled[l] < 1.)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+}
+
+// profiles kept for reuse. Their tables can be large, so only a few
+static constexpr std::size_t CACHE_SIZE = 4;
+
+/**
+ * @brief profile of the beam described by the parameters
+ *
+ * built the first time a table, grid and beam are seen and cached
+ * afterwards (the CACHE_SIZE last used ones), so every scan point and thread
+ * of a run shares one alias table. A relative path is taken from the project directory
+ *
+ * @param p parameters (beam_profile and injection sections, geometry)
+ *
+ * @returns the profile, nullptr for the analytic beam (no file)
+ *
+ * @throws std::runtime_error if the table cannot be read
+ */
+std::shared_ptr<const Beam_profile> beam_profile(const Simulation_params& p)
+{
+    const Beam_profile_params& b = p.beam_profile;
+    if (b.file.empty()) return nullptr;
+    const Injection_params& i = p.injection;
+    std::filesystem::path path = b.file;
+    if (path.is_relative()) path = std::filesystem::path(project_directory()) / path;
+    std::ostringstream key;
+    key << std::hexfloat << path.string() << ' ' << b.z_min << ' ' << b.z_max << ' ' << b.r_max << ' '
+        << b.squared << ' ' << i.wavelength << ' ' << i.NA << ' ' << i.refractive_index << ' '
+        << p.detector.geometry;
+
+    static Resource_cache<std::string, Beam_profile> cache(CACHE_SIZE);
+    return cache.get(key.str(), [&]() {
+        return std::make_shared<const Beam_profile>(path.string(), b, i.wavelength, i.NA, i.refractive_index,
+                                                    p.detector.geometry == "axisymmetric");
+    });
+}
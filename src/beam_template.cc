@@ -0,0 +1,145 @@
+#include "beam_template.hh"
+#include "beam_profile.hh"
+#include "profiler.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief class constructor
+ *
+ * samples N carriers of the TPA density with the inverse CDF used by
+ * Charge_injection::_compute_xy_beam, with the focus at u = 0. With the
+ * default window the whole beam is sampled (the density falls as 1/u^3, so
+ * the CDF is finite at both ends), and a scan point keeps the share of the
+ * shot that lands inside its own window. Axisymmetric templates fill the 3D
+ * focal volume, with x the signed radius (see Charge_injection::_compute_xy_beam)
+ *
+ * @param wavelength laser wavelength (m)
+ * @param numerical_aperture laser numerical aperture
+ * @param refractive_index detector material refractive index
+ * @param N number of carriers
+ * @param seed seed of the sampling
+ * @param u_min lower limit of the sampled depth, relative to the focus (m)
+ * @param u_max upper limit of the sampled depth, relative to the focus (m)
+ * @param axisymmetric sample the 3D focal volume of a cylindrical sensor
+ */
+Beam_template::Beam_template(float wavelength,
+                             float numerical_aperture,
+                             float refractive_index,
+                             int N,
+                             std::uint64_t seed,
+                             float u_min,
+                             float u_max,
+                             bool axisymmetric)
+{
+    if (N <= 0) throw std::invalid_argument("N must be > 0");
+    if (!(u_min < u_max)) throw std::invalid_argument("u_min < u_max required");
+
+    _wavelength = wavelength;
+    _numerical_aperture = numerical_aperture;
+    _refractive_index = refractive_index;
+
+    TCT_PROFILE_SCOPE("injection.beam_template");
+    double w0 = wavelength/(M_PI*numerical_aperture);
+    double b = numerical_aperture/refractive_index;
+    if (!(w0 > 0.0) || !(b > 0.0)) throw std::runtime_error("beam waist and divergence must be positive");
+
+    // g = u/w(u), the CDF up to a constant. Tends to +-1/b for infinite u.
+    // In 3D the density goes as 1/w^2 and g = atan(b*u/w0)
+    auto g_of_u = [&](double u)
+    {
+        if (axisymmetric) return std::atan(b*u/w0);
+        if (std::isinf(u)) return u > 0 ? 1.0/b : -1.0/b;
+        return u/std::sqrt(w0*w0 + b*b*u*u);
+    };
+    double g_min = g_of_u(u_min);
+    double g_max = g_of_u(u_max);
+
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> unif01(0.0, 1.0);
+    std::normal_distribution<float> gauss(0.0, 1.0);
+
+    std::vector<std::pair<float, float>> samples;
+    samples.reserve(N);
+    for (int i = 0; i < N; ++i)
+    {
+        double g = g_min + unif01(gen)*(g_max - g_min);
+        double u;
+        if (axisymmetric)
+            u = w0/b*std::tan(std::clamp(g, -M_PI/2. + 1e-12, M_PI/2. - 1e-12));
+        else
+        {
+            double gb = std::min(std::abs(g*b), 1.0 - 1e-12);
+            u = std::copysign(gb*w0/(b*std::sqrt(1.0 - gb*gb)), g);
+        }
+        double sigma = std::sqrt(w0*w0 + b*b*u*u)/std::sqrt(8.0);
+        float x = gauss(gen);
+        if (axisymmetric) x = std::copysign(std::hypot(x, gauss(gen)), x);
+        samples.emplace_back(static_cast<float>(u), static_cast<float>(sigma)*x);
+    }
+    _store(samples);
+}
+
+/**
+ * @brief class constructor
+ *
+ * samples N carriers of a tabulated beam, each in O(1) from the alias table
+ * of the profile. The profile only covers its own grid, so all the carriers
+ * lie in [z_min, z_max] around the focus
+ *
+ * @param profile tabulated TPA density
+ * @param N number of carriers
+ * @param seed seed of the sampling
+ */
+Beam_template::Beam_template(const Beam_profile& profile, int N, std::uint64_t seed)
+{
+    if (N <= 0) throw std::invalid_argument("N must be > 0");
+
+    _wavelength = profile.get_wavelength();
+    _numerical_aperture = profile.get_NA();
+    _refractive_index = profile.get_refractive_index();
+
+    TCT_PROFILE_SCOPE("injection.beam_template");
+    std::mt19937_64 gen(seed);
+    std::vector<std::pair<float, float>> samples(N);
+    for (auto& s : samples) profile.sample(gen, s.second, s.first);
+    _store(samples);
+}
+
+/**
+ * @brief keep the samples sorted by depth
+ *
+ * @param samples (u, x) pairs. Sorted in place
+ */
+void Beam_template::_store(std::vector<std::pair<float, float>>& samples)
+{
+    std::sort(samples.begin(), samples.end(),
+              [](const auto& a, const auto& c) { return a.first < c.first; });
+
+    _x.reserve(samples.size());
+    _u.reserve(samples.size());
+    for (const auto& s : samples)
+    {
+        _u.push_back(s.first);
+        _x.push_back(s.second);
+    }
+}
+
+/**
+ * @brief carriers inside a depth window
+ *
+ * @param u_lo lower limit, relative to the focus (m)
+ * @param u_hi upper limit, relative to the focus (m)
+ *
+ * @returns [first, last) indices of the carriers with u_lo <= u <= u_hi
+ */
+std::pair<std::size_t, std::size_t> Beam_template::range(float u_lo, float u_hi) const
+{
+    std::size_t first = std::lower_bound(_u.begin(), _u.end(), u_lo) - _u.begin();
+    std::size_t last = std::upper_bound(_u.begin(), _u.end(), u_hi) - _u.begin();
+    return {first, std::max(first, last)};
+}
@@ -0,0 +1,168 @@
+#include "tct.h"
+#include "detector.hh"
+#include "pulse.hh"
+#include "resource_cache.hh"
+#include "simulation_params.hh"
+#include "sweep.hh"
+#include "thread_pool.hh"
+#include "utility.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @struct tct_simulation
+ *
+ * what a C handle holds
+ */
+struct tct_simulation
+{
+    Simulation_params params;
+    std::unique_ptr<Thread_pool> pool;
+    std::string error;
+};
+
+/**
+ * @brief run a call, turning exceptions into the error of the handle
+ *
+ * @returns 0 on success, -1 on failure
+ */
+template <class F>
+static int _guard(tct_simulation* sim, F&& f)
+{
+    if (!sim) return -1;
+    try {
+        f();
+        sim->error.clear();
+        return 0;
+    }
+    catch (const std::exception& e) {
+        sim->error = e.what();
+    }
+    catch (...) {
+        sim->error = "unknown error";
+    }
+    return -1;
+}
+
+/**
+ * @brief copy a waveform to a caller buffer, if any
+ */
+static void _copy(const std::vector<float>& from, float* to)
+{
+    if (to) std::copy(from.begin(), from.end(), to);
+}
+
+extern "C" {
+
+int tct_api_version(void)
+{
+    return 2;
+}
+
+void tct_set_project_directory(const char* dir)
+{
+    set_project_directory(dir ? dir : "");
+}
+
+void tct_clear_caches(void)
+{
+    clear_resource_caches();
+}
+
+tct_simulation* tct_create(const char* config_json, char* error, size_t error_size)
+{
+    try {
+        std::unique_ptr<tct_simulation> sim(new tct_simulation);
+        sim->params = parse_simulation_params(nlohmann::json::parse(config_json ? config_json : ""));
+        sim->pool.reset(new Thread_pool(sim->params.simulation.threads));
+        return sim.release();
+    }
+    catch (const std::exception& e) {
+        if (error && error_size > 0)
+        {
+            std::strncpy(error, e.what(), error_size - 1);
+            error[error_size - 1] = '\0';
+        }
+    }
+    return nullptr;
+}
+
+void tct_destroy(tct_simulation* sim)
+{
+    delete sim;
+}
+
+const char* tct_last_error(const tct_simulation* sim)
+{
+    return sim ? sim->error.c_str() : "null handle";
+}
+
+int tct_set_parameter(tct_simulation* sim, const char* name, double value)
+{
+    return _guard(sim, [&]() {
+        // the new value must pass the checks of the configuration file
+        Simulation_params p = sim->params;
+        set_parameter(p, name ? name : "", static_cast<float>(value));
+        nlohmann::json data = to_json(p);
+        data["simulation"]["type"] = "z_scan";
+        parse_simulation_params(data);
+        sim->params = p;
+    });
+}
+
+int tct_get_steps(const tct_simulation* sim)
+{
+    return sim ? sim->params.simulation.steps : -1;
+}
+
+double tct_get_dt(const tct_simulation* sim)
+{
+    return sim ? sim->params.simulation.dt : -1.;
+}
+
+int tct_simulate_pulse(tct_simulation* sim, double focus, uint64_t seed,
+                       float* signal_e, float* signal_h, float* signal_total, float* filtered,
+                       double* charge, double* WPC)
+{
+    return _guard(sim, [&]() {
+        Detector det = make_detector(sim->params.detector);
+        Pulse pulse = simulate_pulse(focus, sim->params, &det, seed, sim->pool.get());
+        _copy(pulse.signal_e, signal_e);
+        _copy(pulse.signal_h, signal_h);
+        _copy(pulse.signal_total, signal_total);
+        _copy(pulse.filtered, filtered);
+        if (charge) *charge = pulse.charge;
+        if (WPC) *WPC = pulse.WPC;
+    });
+}
+
+int tct_z_scan(tct_simulation* sim, const double* foci, size_t n,
+               float* signal_total, float* filtered, double* charge, double* WPC)
+{
+    return _guard(sim, [&]() {
+        if (n == 0) return;
+        if (!foci) throw std::invalid_argument("tct_z_scan: no foci");
+        Simulation_params scan = sim->params;
+        scan.sweeps.combine = "product";
+        scan.sweeps.axes = {Sweep_axis{"injection.focus", std::vector<float>(foci, foci + n)}};
+        std::vector<Sweep_point> points = make_sweep_points(scan);
+
+        // each point goes to its row as soon as it is done
+        std::size_t steps = static_cast<std::size_t>(scan.simulation.steps);
+        const Sweep_point* first = points.data();
+        run_sweep(points, *sim->pool, [&](const Sweep_point& pt) {
+            std::size_t i = &pt - first;
+            _copy(pt.pulse.signal_total, signal_total ? signal_total + i*steps : nullptr);
+            _copy(pt.pulse.filtered, filtered ? filtered + i*steps : nullptr);
+            if (charge) charge[i] = pt.pulse.charge;
+            if (WPC) WPC[i] = pt.pulse.WPC;
+        });
+    });
+}
+
+}
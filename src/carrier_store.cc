@@ -0,0 +1,91 @@
+#include "carrier_store.hh"
+
+/**
+ * @brief reserve memory
+ *
+ * reserves room for n carriers in every array
+ *
+ * @param n number of carriers
+ */
+void Carrier_store::reserve(std::size_t n)
+{
+    _x.reserve(n);
+    _y.reserve(n);
+    _vx.reserve(n);
+    _vy.reserve(n);
+    _w.reserve(n);
+    _id.reserve(n);
+}
+
+/**
+ * @brief remove all carriers
+ */
+void Carrier_store::clear()
+{
+    _x.clear();
+    _y.clear();
+    _vx.clear();
+    _vy.clear();
+    _w.clear();
+    _id.clear();
+}
+
+/**
+ * @brief add a carrier
+ *
+ * appends a carrier at rest at position (x, y). Its id is its index
+ *
+ * @param x position of the carrier in the x axis (m)
+ * @param y position of the carrier in the y axis (m)
+ * @param weight number of elementary charges represented by the carrier
+ */
+void Carrier_store::push_back(float x, float y, float weight)
+{
+    _id.push_back(static_cast<std::uint32_t>(_x.size()));
+    _x.push_back(x);
+    _y.push_back(y);
+    _vx.push_back(0.);
+    _vy.push_back(0.);
+    _w.push_back(weight);
+}
+
+/**
+ * @brief drop the carriers outside a box
+ *
+ * removes every carrier whose position is outside [x_min, x_max] x
+ * [y_min, y_max], keeping the order of the others. Used to take collected
+ * carriers out of the working arrays
+ *
+ * @param x_min lower x limit (m)
+ * @param x_max upper x limit (m)
+ * @param y_min lower y limit (m)
+ * @param y_max upper y limit (m)
+ *
+ * @returns number of carriers left
+ */
+std::size_t Carrier_store::compact(float x_min, float x_max, float y_min, float y_max)
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < _x.size(); ++i)
+    {
+        if (_x[i] < x_min || _x[i] > x_max || _y[i] < y_min || _y[i] > y_max)
+            continue;
+        if (n != i)
+        {
+            _x[n] = _x[i];
+            _y[n] = _y[i];
+            _vx[n] = _vx[i];
+            _vy[n] = _vy[i];
+            _w[n] = _w[i];
+            _id[n] = _id[i];
+        }
+        ++n;
+    }
+    _x.resize(n);
+    _y.resize(n);
+    _vx.resize(n);
+    _vy.resize(n);
+    _w.resize(n);
+    _id.resize(n);
+    return n;
+}
@@ -1,16 +1,20 @@
 #include "charge_injection.hh"
-#include "charge_carrier.hh"
 #include "detector.hh"
+#include "electric_field.hh"
+#include "profiler.hh"
+#include "resource_cache.hh"
 #include "utility.hh"
 
-#include <iostream>
+#include <stdexcept>
 #include <random>
 #include <cmath>
 #include <algorithm>
-#include <filesystem>
 
 #define H_BAR 1.0546e-34 // Planck constant over 2pi
 
+// measured v(E) curves kept for reuse (one per carrier type and material)
+static constexpr std::size_t CACHE_SIZE = 8;
+
 /**
  * @brief class constructor
  * 
@@ -24,6 +28,9 @@
  * @param det detector geometry
  * @param type type of the carriers. 0->electrons, 1->holes
  * @param N number of charges
+ * @param seed seed of the random sampling of the charge positions
+ * @param importance_fraction share of the charges placed in the depleted
+ *                            region, 0 for analog sampling
  */
 Charge_injection::Charge_injection(float focus,
                                    float wavelength, 
@@ -31,7 +38,9 @@ Charge_injection::Charge_injection(float focus,
                                    float refractive_index,
                                    Detector* det,
                                    int type,
-                                   int N)
+                                   int N,
+                                   std::uint64_t seed,
+                                   float importance_fraction)
 {
     _focus = focus;
     _wavelength = wavelength;
@@ -41,15 +50,52 @@ Charge_injection::Charge_injection(float focus,
     _det = det;
     _n_of_charges = N;
 
-    _charges_per_point_init = _compute_xy_beam(_n_of_charges, -64.e-6, 64.e-6, std::random_device{}(), 200000);
-    _create_injection();
-    std::cout << "Simulating " << _charges.size() << " charges" << std::endl;
+    {
+        TCT_PROFILE_SCOPE("injection.sample");
+        _charges_per_point_init = _compute_xy_beam(_n_of_charges, -64.e-6, 64.e-6, seed, importance_fraction);
+        _create_injection();
+    }
+    TCT_PROFILE_COUNT("injection.sampled", N);
+    TCT_PROFILE_COUNT("injection.kept", _charges.size());
 
-    std::filesystem::path cwd = std::filesystem::current_path().parent_path();
-    if(_type == 0)
-        readCSV(cwd.string() + "/exp_data/electron_drift_velocity.csv", _E_field_experimental_range, _velocity_exp);
-    else
-        readCSV(cwd.string() + "/exp_data/hole_drift_velocity.csv", _E_field_experimental_range, _velocity_exp);   
+    _load_velocity_table();
+}
+
+/**
+ * @brief class constructor
+ * 
+ * takes the carriers from a beam template instead of sampling them. The
+ * template is translated to the given focus and clipped to the same depth
+ * window as the sampling constructor, so the number of carriers is the share
+ * of the template that falls inside the window
+ * 
+ * @param beam carriers sampled around the focus
+ * @param focus depth at which the laser is focused (m)
+ * @param det detector geometry
+ * @param type type of the carriers. 0->electrons, 1->holes
+ */
+Charge_injection::Charge_injection(const Beam_template& beam, float focus, Detector* det, int type)
+{
+    _focus = focus;
+    _wavelength = beam.get_wavelength();
+    _numerical_aperture = beam.get_NA();
+    _refractive_index = beam.get_refractive_index();
+    _type = type;
+    _det = det;
+
+    {
+        TCT_PROFILE_SCOPE("injection.from_template");
+        auto [first, last] = beam.range(-64.e-6 - focus, 64.e-6 - focus);
+        _n_of_charges = last - first;
+        _charges.reserve(last - first);
+        for (std::size_t i = first; i < last; ++i)
+            _charges.push_back(beam.x()[i], beam.u()[i] + focus);
+    }
+    // the carriers of the template that fall inside the window
+    TCT_PROFILE_COUNT("injection.sampled", beam.size());
+    TCT_PROFILE_COUNT("injection.kept", _n_of_charges);
+
+    _load_velocity_table();
 }
 
 /**
@@ -71,55 +117,111 @@ float Charge_injection::_compute_beam_width(float y)
  * @brief calculate the position of the charges
  * 
  * distributes N charges in space according to the TPA-TCT charge carrier
- * density profile (gaussian^2)
+ * density profile (gaussian^2). Integrated over x, the density along y is
+ * proportional to 1/w(y)^3 with w(y)^2 = w0^2 + (b*(y - focus))^2, whose
+ * integral is u/(w0^2*w(u)), u = y - focus. y is drawn by inverting that CDF
+ * in closed form and x from a gaussian of width w(y)/sqrt(8).
+ * 
+ * With importance sampling the window is split in two strata, the depleted
+ * region and the rest. A share importance_fraction of the charges is drawn
+ * inside the depleted region and the others outside it. Each stratum is
+ * weighted by its share of the whole beam over its number of charges, so N
+ * stands for the charge of the full shot (as with a Beam_template) and the
+ * weights add up to N times the share of the beam inside the window. Without
+ * importance sampling every charge has that share as its weight, so both
+ * ways give the same normalisation. The weights are stored in
+ * _weights_per_point_init
+ * 
+ * In the axisymmetric geometry the carriers fill the 3D focal volume: the
+ * density along y is then proportional to 1/w(y)^2, whose CDF goes as
+ * atan(b*u/w0), and x is the radius (drawn with its Jacobian, a Rayleigh
+ * distribution of the same sigma) on a random side of the axis
  * 
  * @param N number of charges
  * @param y_min lower limit of the distribution on the y axis (m)
  * @param y_max upper limit of the distribution on the x axis (m)
  * @param seed seed for the random distribution
- * @param grid_for_max_search required for the rejection sampling algorithm
+ * @param importance_fraction share of the charges drawn in the depleted
+ *                            region. 0 samples the beam as it is
  * 
  * @returns vector of pairs with the x and y coordinates of the N charges
  */
 std::vector<std::pair<float, float>> Charge_injection::_compute_xy_beam(int N,
                                                                         float y_min,
                                                                         float y_max,
-                                                                        unsigned seed,
-                                                                        int grid_for_max_search)
+                                                                        std::uint64_t seed,
+                                                                        float importance_fraction)
 {
     if (N <= 0) throw std::invalid_argument("N must be > 0");
     if (!(y_min < y_max)) throw std::invalid_argument("y_min < y_max required");
 
+    // w(y) of _compute_beam_width as w0^2 + (b*u)^2
+    double w0 = _wavelength/(M_PI*_numerical_aperture);
+    double b = _numerical_aperture/_refractive_index;
+    if (!(w0 > 0.0) || !(b > 0.0)) throw std::runtime_error("beam waist and divergence must be positive");
+
+    // normalised CDF variable g = w0^2 * int 1/w^3 = u/w(u), in (-1/b, 1/b),
+    // or g = w0*b * int 1/w^2 = atan(b*u/w0), in (-pi/2, pi/2), in 3D
+    bool axisymmetric = _det->get_geometry() == "axisymmetric";
+    auto g_of_u = [&](double u)
+    {
+        if (axisymmetric) return std::atan(b*u/w0);
+        return u/std::sqrt(w0*w0 + b*b*u*u);
+    };
+    auto u_of_g = [&](double g)
+    {
+        if (axisymmetric) return w0/b*std::tan(g);
+        return g*w0/std::sqrt(1.0 - g*g*b*b);
+    };
+    // probability per unit of g
+    double p_of_g = axisymmetric ? 1./M_PI : b/2.;
+    double g_min = g_of_u(y_min - _focus);
+    double g_max = g_of_u(y_max - _focus);
+
     std::mt19937_64 gen(seed);
-    std::uniform_real_distribution<float> unif_y(y_min, y_max);
-    std::uniform_real_distribution<float> unif01(0.0, 1.0);
-
-    float min_w = std::numeric_limits<float>::infinity();
-    for (int i = 0; i < grid_for_max_search; ++i) {
-        float frac = (float)i / (grid_for_max_search - 1);
-        float y = y_min + frac * (y_max - y_min);
-        float w = _compute_beam_width(y);
-        if (!(w > 0.0)) throw std::runtime_error("w_of_y must return positive values");
-        if (w < min_w) min_w = w;
-    }
-    if (!std::isfinite(min_w) || min_w <= 0.0) throw std::runtime_error("could not determine positive min w");
+    std::uniform_real_distribution<double> unif01(0.0, 1.0);
+    std::normal_distribution<float> gauss(0.0, 1.0);
 
-    float max_py = 1.0 / (min_w * min_w * min_w);
+    // CDF is linear in g, so the probability of a stratum is its g length
+    float depth = std::min(_det->get_depleted_width(), _det->get_physical_width());
+    double g_lo = g_of_u(std::clamp(0.f, y_min, y_max) - _focus);
+    double g_hi = g_of_u(std::clamp(depth, y_min, y_max) - _focus);
+    // probabilities relative to the whole beam, so N is the charge of the
+    // full shot as for a Beam_template
+    double P_window = (g_max - g_min)*p_of_g;
+    double P_in = (g_hi - g_lo)*p_of_g;
+    double P_out = P_window - P_in;
+    int N_in = 0;
+    if (importance_fraction > 0. && P_in > 0. && P_out > 0.)
+        N_in = std::clamp(static_cast<int>(std::lround(importance_fraction*N)), 1, N - 1);
+    float w_in = N_in > 0 ? P_in*N/N_in : 1.;
+    float w_out = N_in > 0 ? P_out*N/(N - N_in) : 1.;
 
     std::vector<std::pair<float,float>> samples;
     samples.reserve(N);
-
-    while ((int)samples.size() < N) {
-        float y = unif_y(gen);
-        float w = _compute_beam_width(y);
-        float py = 1.0 / (w*w*w);
-        float u = unif01(gen) * max_py;
-        if (u <= py) {
-            float sigma = w / std::sqrt(8.0);
-            std::normal_distribution<float> gauss_x(0.0, sigma);
-            float x = gauss_x(gen);
-            samples.emplace_back(x, y);
+    // analog sampling (also the fallback when a stratum is empty) weights
+    // every charge by the share of the beam in the window, as the strata do
+    _weights_per_point_init.assign(N, static_cast<float>(P_window));
+    for (int i = 0; i < N; ++i) {
+        double g;
+        if (N_in == 0) {
+            g = g_min + unif01(gen)*(g_max - g_min);
         }
+        else if (i < N_in) {
+            g = g_lo + unif01(gen)*(g_hi - g_lo);
+            _weights_per_point_init[i] = w_in;
+        }
+        else {
+            double r = unif01(gen)*((g_lo - g_min) + (g_max - g_hi));
+            g = r < g_lo - g_min ? g_min + r : g_hi + (r - (g_lo - g_min));
+            _weights_per_point_init[i] = w_out;
+        }
+        double u = u_of_g(g);
+        float y = std::clamp<float>(_focus + u, y_min, y_max);
+        float sigma = _compute_beam_width(y)/std::sqrt(8.0);
+        float x = gauss(gen);
+        if (axisymmetric) x = std::copysign(std::hypot(x, gauss(gen)), x);
+        samples.emplace_back(sigma*x, y);
     }
 
     return samples;
@@ -135,19 +237,59 @@ std::vector<std::pair<float, float>> Charge_injection::_compute_xy_beam(int N,
 void Charge_injection::set_type(int type)
 {
     _type = type;
-    _E_field_experimental_range.clear();
-    _velocity_exp.clear();
-    std::filesystem::path cwd = std::filesystem::current_path().parent_path();
-    if(_type == 0)
+    _load_velocity_table();
+}
+
+/**
+ * @brief measured v(E) curve
+ *
+ * every injection of a run uses the same curves: each file is read once
+ *
+ * @param name file in exp_data/
+ *
+ * @returns field (MV/cm) and drift velocity (cm/s) of the curve
+ */
+static std::shared_ptr<const std::pair<std::vector<float>, std::vector<float>>> _measured_curve(const std::string& name)
+{
+    static Resource_cache<std::string, std::pair<std::vector<float>, std::vector<float>>> cache(CACHE_SIZE);
+    return cache.get(name, [&]() {
+        TCT_PROFILE_SCOPE("io.read_csv");
+        auto curve = std::make_shared<std::pair<std::vector<float>, std::vector<float>>>();
+        readCSV(project_directory() + "/exp_data/" + name, curve->first, curve->second);
+        if (curve->first.empty())
+            throw std::runtime_error("Charge_injection: could not read the drift velocity curve");
+        return curve;
+    });
+}
+
+/**
+ * @brief load the v(E) data
+ * 
+ * tabulates the drift velocity of the current carrier type in the detector
+ * material up to the largest field of the detector field map: the measured
+ * curve if the material has one (see material.hh), the Caughey-Thomas model
+ * otherwise
+ */
+void Charge_injection::_load_velocity_table()
+{
+    TCT_PROFILE_SCOPE("injection.velocity_table");
+    const Material& material = _det->get_material_properties();
+    const Carrier_properties& carrier = _type == 0 ? material.e : material.h;
+
+    _field = electric_field(_det);
+    const float* ex = _field->fx();
+    const float* ey = _field->fy();
+    float E_max = 0.;
+    for (int i = 0; i < _field->get_nx()*_field->get_ny(); ++i)
+        E_max = std::max(E_max, std::sqrt(ex[i]*ex[i] + ey[i]*ey[i]));
+
+    if (carrier.velocity_curve)
     {
-        readCSV(cwd.string() + "/exp_data/electron_drift_velocity.csv", _E_field_experimental_range, _velocity_exp);
-        std::cout << "Initializing electron injection" << std::endl;
+        auto curve = _measured_curve(carrier.velocity_curve);
+        _velocity_table = Velocity_table(curve->first, curve->second, E_max);
     }
     else
-    {
-        readCSV(cwd.string() + "/exp_data/hole_drift_velocity.csv", _E_field_experimental_range, _velocity_exp);   
-        std::cout << "Initializing hole injection" << std::endl;
-    }
+        _velocity_table = Velocity_table(carrier.mobility, carrier.saturation_velocity, carrier.exponent, E_max);
 }
 
 /**
@@ -157,9 +299,46 @@ void Charge_injection::set_type(int type)
  */
 void Charge_injection::_create_injection()
 {
-    for(const auto& p : _charges_per_point_init)
+    _charges.clear();
+    _charges.reserve(_charges_per_point_init.size());
+    for(std::size_t i = 0; i < _charges_per_point_init.size(); ++i)
+    {
+        const auto& p = _charges_per_point_init[i];
+        _charges.push_back(p.first, p.second, _weights_per_point_init[i]);
+    }
+}
+
+/**
+ * @brief update_speeds for one carrier type
+ *
+ * the carrier type is a template parameter so the polarity is a constant of
+ * the loop
+ *
+ * @tparam TYPE carrier type. 0->electrons, 1->holes
+ */
+template <int TYPE>
+static void _update_speeds(Carrier_store& charges, const Field_map& field, const Velocity_table& table,
+                           float x_lim, float y_lim)
+{
+    constexpr float polarity = TYPE == 0 ? 1. : -1.;
+    float* x = charges.x();
+    float* y = charges.y();
+    float* vx = charges.vx();
+    float* vy = charges.vy();
+    for (std::size_t i = 0; i < charges.size(); ++i)
     {
-        _charges.emplace_back(p.first, p.second, _type);
+        if (y[i] > y_lim || y[i] < 0. || x[i] > x_lim || x[i] < -x_lim)
+        {
+            vx[i] = 0.;
+            vy[i] = 0.;
+            continue;
+        }
+        float Ex, Ey;
+        field.sample(x[i], y[i], Ex, Ey);
+        float E = std::sqrt(Ex*Ex + Ey*Ey);
+        float scale = E > 0. ? polarity*table(E)/E : 0.;
+        vx[i] = scale*Ex;
+        vy[i] = scale*Ey;
     }
 }
 
@@ -167,37 +346,22 @@ void Charge_injection::_create_injection()
  * @brief Updates the speeds of the carriers
  * 
  * Updates the drift velocities of the charge carriers according to the local
- * electric field at their respective positions. If the charge exits the edges
+ * electric field at their respective positions, taken from the field map.
+ * Carriers move along the field (electrons) or against it (holes) with the
+ * speed of the v(E) table at its magnitude. If the charge exits the edges
  * of the detector, the velocity is set to 0
  */
 void Charge_injection::update_speeds()
 {
-    float E = 0.;
-    float v = 0.;
-    float x_lim = _det->get_depleted_width();
+    float y_lim = _det->get_depleted_width();
     if (_det->get_depleted_width() > _det->get_physical_width())
-        x_lim = _det->get_physical_width();
+        y_lim = _det->get_physical_width();
+    float x_lim = _det->get_physical_length()/2.;
 
-    for (auto& charge : _charges)
-    {
-        auto pos = charge.get_position();
-        if (pos.second > x_lim || pos.second < 0.)
-            charge.set_velocity(0., 0.);
-        else
-        {
-            E = linear_field(pos.first, pos.second, _det);
-            // v = linear_interpolation(E/1e8, _E_field_experimental_range, _velocity_exp)*1e-2;
-            if(_type == 0)
-            {
-                v = 450e-4*1e6;
-            }
-            else
-            {
-                v = 90e-4*1e6;
-            }
-            charge.set_velocity(0., v);
-        }
-    }
+    if (_type == 0)
+        _update_speeds<0>(_charges, *_field, _velocity_table, x_lim, y_lim);
+    else
+        _update_speeds<1>(_charges, *_field, _velocity_table, x_lim, y_lim);
 }
 
 /**
@@ -207,7 +371,19 @@ void Charge_injection::update_speeds()
  * 
  * @returns the charge carrier vector
  */
-std::vector<Charge_carrier>& Charge_injection::get_charges()
+Carrier_store& Charge_injection::get_charges()
 {
     return _charges;
 }
+
+/**
+ * @brief get the v(E) table
+ * 
+ * accesses the tabulated drift velocity of the current carrier type
+ * 
+ * @returns the velocity table
+ */
+const Velocity_table& Charge_injection::get_velocity_table() const
+{
+    return _velocity_table;
+}
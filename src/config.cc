@@ -7,12 +7,15 @@ using json = nlohmann::json;
 /**
  * @brief class constructor
  * 
- * loads the json file
+ * loads the json file and parses it into the simulation parameters
  * 
  * @param filepath name of the file. The file should be at the up-most directory
+ * 
+ * @throws Config_error if the configuration does not validate
  */
 Config::Config(const std::string& filepath) {
     _load_json(filepath);
+    _params = parse_simulation_params(_data);
 }
 
 /**
@@ -29,24 +32,32 @@ void Config::_load_json(const std::string& filepath) {
 }
 
 // --- Detector ---
-float Config::get_Nd() const { return _data["detector"]["Nd"]; }
-float Config::get_width() const { return _data["detector"]["width"]; }
-float Config::get_length() const { return _data["detector"]["length"]; }
-float Config::get_V_bi() const { return _data["detector"]["V_bi"]; }
-float Config::get_V_bias() const { return _data["detector"]["V_bias"]; }
-float Config::get_R() const { return _data["detector"]["R"]; }
-std::string Config::get_material() const { return _data["detector"]["material"]; }
+float Config::get_Nd() const { return _params.detector.Nd; }
+float Config::get_width() const { return _params.detector.width; }
+float Config::get_length() const { return _params.detector.length; }
+float Config::get_V_bi() const { return _params.detector.V_bi; }
+float Config::get_V_bias() const { return _params.detector.V_bias; }
+float Config::get_R() const { return _params.detector.R; }
+float Config::get_electrode_width() const { return _params.detector.electrode_width; }
+std::string Config::get_material() const { return _params.detector.material; }
+std::string Config::get_field_model() const { return _params.detector.field_model; }
+std::string Config::get_geometry() const { return _params.detector.geometry; }
 
 // --- Injection ---
-float Config::get_focus() const { return _data["injection"]["focus"]; }
-float Config::get_wavelength() const { return _data["injection"]["wavelength"]; }
-float Config::get_NA() const { return _data["injection"]["NA"]; }
-float Config::get_refractive_index() const { return _data["injection"]["refractive_index"]; }
-int Config::get_type() const { return _data["injection"]["type"]; }
-int Config::get_N() const { return _data["injection"]["N"]; }
+float Config::get_focus() const { return _params.injection.focus; }
+float Config::get_wavelength() const { return _params.injection.wavelength; }
+float Config::get_NA() const { return _params.injection.NA; }
+float Config::get_refractive_index() const { return _params.injection.refractive_index; }
+int Config::get_N() const { return _params.injection.N; }
+float Config::get_importance_fraction() const { return _params.injection.importance_fraction; }
 
 // --- Simulation ---
-int Config::get_steps() const { return _data["simulation"]["steps"]; }
-float Config::get_dt() const { return _data["simulation"]["dt"]; }
-float Config::get_t_pc() const { return _data["simulation"]["t_pc"]; }
-std::string Config::get_sim_type() const { return _data["simulation"]["type"]; }
\ No newline at end of file
+int Config::get_steps() const { return _params.simulation.steps; }
+float Config::get_dt() const { return _params.simulation.dt; }
+float Config::get_t_pc() const { return _params.simulation.t_pc; }
+std::string Config::get_sim_type() const { return _params.simulation.type; }
+std::string Config::get_engine() const { return _params.simulation.engine; }
+bool Config::get_diffusion() const { return _params.simulation.diffusion; }
+bool Config::get_trapping() const { return _params.simulation.trapping; }
+int Config::get_threads() const { return _params.simulation.threads; }
+std::uint64_t Config::get_seed() const { return _params.simulation.seed; }
@@ -1,7 +1,7 @@
 #include "detector.hh"
 
-#include <iostream>
 #include <math.h>
+#include <stdexcept>
 
 #define QE 1.602e-19
 #define EPS_0 8.854e-12
@@ -17,7 +17,13 @@ Detector::Detector(float Nd, float W, float L, float V_bi, float V_bias, float R
     _built_in_voltage = V_bi;
     _bias_voltage = V_bias;
     _resistance = R;
-    _capacitance = 1.6111e-12;
+    _capacitance = DEFAULT_CAPACITANCE;
+    _electrode_width = L;
+    _field_model = "linear";
+    _geometry = "planar";
+    _fluence = 0.;
+    _e_trapping_constant = 0.;
+    _h_trapping_constant = 0.;
 
     _depleted_width = _calculate_depleted_width();
     _depletion_voltage = _calculate_depletion_voltage();
@@ -35,23 +41,14 @@ float Detector::_calculate_depletion_voltage()
 
 void Detector::_initialize_material()
 {
-    if(_material == "SiC")
-    {
-        _eps = 9.72;
-        _e_diffusion_constant = 22.e-4;
-        _h_diffusion_constant = 3.e-4;
-        _e_lifetime = 1.e-9;
-        _h_lifetime = 6.e-7;
-    }
-    else
-    {
-        std::cout << "Detector::_find_eps: error: unrecognised material. Defaulting to SiC" << std::endl;
-        _eps = 9.72;
-        _e_diffusion_constant = 22.e-4;
-        _h_diffusion_constant = 3.e-4;
-        _e_lifetime = 1.e-9;
-        _h_lifetime = 6.e-7;
-    }
+    _properties = find_material(_material);
+    if (!_properties)
+        throw std::invalid_argument("Detector: unknown material " + _material);
+    _eps = _properties->eps;
+    _e_diffusion_constant = _properties->e.diffusion_constant;
+    _h_diffusion_constant = _properties->h.diffusion_constant;
+    _e_lifetime = _properties->e.lifetime;
+    _h_lifetime = _properties->h.lifetime;
 }
 
 void Detector::set_doping_concentration(float Nd)
@@ -63,6 +60,7 @@ void Detector::set_doping_concentration(float Nd)
 void Detector::set_material(const std::string& mat)
 {
     _material = mat;
+    _initialize_material();
     _detector_has_been_modified();
 }
 
@@ -89,6 +87,63 @@ void Detector::set_resistance(float R)
     _resistance = R;
 }
 
+void Detector::set_capacitance(float C)
+{
+    _capacitance = C;
+}
+
+void Detector::set_electrode_width(float w)
+{
+    _electrode_width = w;
+}
+
+void Detector::set_field_model(const std::string& model)
+{
+    _field_model = model;
+}
+
+void Detector::set_geometry(const std::string& geometry)
+{
+    _geometry = geometry;
+}
+
+void Detector::set_e_lifetime(float tau)
+{
+    _e_lifetime = tau;
+}
+
+void Detector::set_h_lifetime(float tau)
+{
+    _h_lifetime = tau;
+}
+
+void Detector::set_fluence(float fluence)
+{
+    _fluence = fluence;
+}
+
+void Detector::set_e_trapping_constant(float beta)
+{
+    _e_trapping_constant = beta;
+}
+
+void Detector::set_h_trapping_constant(float beta)
+{
+    _h_trapping_constant = beta;
+}
+
+// effective trapping times: the lifetime of the material shortened by the
+// traps of the irradiation, 1/tau_eff = 1/tau + beta*fluence
+float Detector::get_e_trapping_time()
+{
+    return 1./(1./_e_lifetime + _e_trapping_constant*_fluence);
+}
+
+float Detector::get_h_trapping_time()
+{
+    return 1./(1./_h_lifetime + _h_trapping_constant*_fluence);
+}
+
 void Detector::set_physical_length(float L)
 {
     _physical_length = L;
@@ -96,7 +151,6 @@ void Detector::set_physical_length(float L)
 
 void Detector::_detector_has_been_modified()
 {
-    _initialize_material();
     _depleted_width = _calculate_depleted_width();
     _depletion_voltage = _calculate_depletion_voltage();
 }
\ No newline at end of file
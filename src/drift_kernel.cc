@@ -0,0 +1,204 @@
+#include "drift_kernel.hh"
+#include "detector.hh"
+#include "simd.hh"
+#include "random.hh"
+
+#include <cmath>
+
+/**
+ * @brief build the drift kernel constants
+ *
+ * collects from the detector the limits of the field region and points the
+ * kernel at the v(E) table of the carrier type. Diffusion is set to the
+ * diffusion constant of the carrier type and trapping to its effective
+ * trapping time; the generator key and counter and the electric and
+ * weighting field maps are left to the caller
+ *
+ * @param det detector geometry
+ * @param table drift velocity of the carrier type
+ * @param type carrier type. 0->electrons, 1->holes
+ * @param dt time step (s)
+ *
+ * @returns kernel constants for one step
+ */
+Drift_params make_drift_params(Detector* det, const Velocity_table& table, int type, float dt)
+{
+    Drift_params p;
+    p.dt = dt;
+    p.y_max = det->get_depleted_width();
+    if (det->get_depleted_width() > det->get_physical_width())
+        p.y_max = det->get_physical_width();
+    p.x_half = det->get_physical_length()/2.;
+    p.type = type;
+
+    p.v = table.v();
+    p.dv = table.dv();
+    p.inv_dE = table.get_inv_dE();
+    p.max_index = table.get_max_index();
+
+    float D = type == 0 ? det->get_e_diffusion_constant() : det->get_h_diffusion_constant();
+    p.sigma = std::sqrt(2*D*dt);
+    float tau = type == 0 ? det->get_e_trapping_time() : det->get_h_trapping_time();
+    p.decay = std::exp(-dt/tau);
+    p.axisymmetric = det->get_geometry() == "axisymmetric";
+    p.key0 = 0;
+    p.key1 = 0;
+    p.counter = 0;
+    return p;
+}
+
+/**
+ * @brief kernel body for one instruction set
+ *
+ * processes carriers [begin, end) in blocks of V::width lanes. end - begin
+ * must be a multiple of V::width. The carrier type is a template parameter,
+ * so the polarity folds into the arithmetic. With DIFFUSION, carriers in the
+ * field region are also displaced by sigma times a gaussian deviate on each
+ * axis, drawn from Threefry keyed by (key0, key1) with counter
+ * (id, counter). With AXISYMMETRIC a third deviate (counter with its top bit
+ * set) moves the carrier out of the (r, y) plane and the new radius is the
+ * distance to the axis, keeping the side of the plane. The weights decay by
+ * p.decay after the current of the step is taken
+ *
+ * @tparam TYPE carrier type. 0->electrons (drift along the field), 1->holes
+ *
+ * @returns sum of polarity * v . E_w * weight over the processed carriers
+ */
+template <class V, int TYPE, bool DIFFUSION, bool AXISYMMETRIC>
+static float _drift_block(Carrier_store& store, std::size_t begin, std::size_t end, const Drift_params& p)
+{
+    const std::uint32_t* id = store.id();
+    const rng::Normal_table& normal = rng::normal_table();
+    const typename V::vf sigma = V::set1(p.sigma);
+    float* x = store.x();
+    float* y = store.y();
+    float* vx = store.vx();
+    float* vy = store.vy();
+    float* w = store.weight();
+
+    const typename V::vf zero = V::set1(0.);
+    const typename V::vf dt = V::set1(p.dt);
+    const typename V::vf decay = V::set1(p.decay);
+    const typename V::vf E_floor = V::set1(1e-6);
+    const typename V::vf inv_dE = V::set1(p.inv_dE);
+    const typename V::vf max_index = V::set1(p.max_index);
+    const typename V::vf top = V::set1(p.max_index + 1.);
+    const typename V::vf y_max = V::set1(p.y_max);
+    const typename V::vf x_max = V::set1(p.x_half);
+    const typename V::vf x_min = V::set1(-p.x_half);
+
+    typename V::vf acc = zero;
+    for(std::size_t i = begin; i < end; i += V::width)
+    {
+        typename V::vf xi = V::load(x + i);
+        typename V::vf yi = V::load(y + i);
+        typename V::vm inside = V::land(V::land(V::ge(yi, zero), V::le(yi, y_max)),
+                                        V::land(V::ge(xi, x_min), V::le(xi, x_max)));
+        // field and weighting field share the grid: one cell for both
+        Field_cell<V> cell = locate<V>(p.field, xi, yi);
+        typename V::vf Ex = interpolate<V>(cell, p.field.fx, p.field.nx);
+        typename V::vf Ey = interpolate<V>(cell, p.field.fy, p.field.nx);
+        typename V::vf E = V::sqrt(V::fmadd(Ex, Ex, V::mul(Ey, Ey)));
+        // table lookup: f = E/dE clamped to the grid, v = v[i] + (f - i)*dv[i]
+        typename V::vf f = V::min(V::max(V::mul(E, inv_dE), zero), top);
+        typename V::vf idx = V::min(V::trunc(f), max_index);
+        typename V::vf v = V::fmadd(V::sub(f, idx), V::gather(p.dv, idx), V::gather(p.v, idx));
+        // velocity along the field (electrons) or against it (holes), v * E/|E|
+        typename V::vf ratio = V::div(v, V::max(E, E_floor));
+        if constexpr (TYPE == 1) ratio = V::sub(zero, ratio);
+        typename V::vf scale = V::select(inside, ratio, zero);
+        typename V::vf vxi = V::mul(scale, Ex);
+        typename V::vf vyi = V::mul(scale, Ey);
+        V::store(vx + i, vxi);
+        V::store(vy + i, vyi);
+        typename V::vf x_new = V::fmadd(dt, vxi, xi);
+        typename V::vf y_new = V::fmadd(dt, vyi, yi);
+        if constexpr (DIFFUSION)
+        {
+            typename V::vi r0 = V::load_u(id + i);
+            typename V::vi r1 = V::set1_u(p.counter);
+            rng::threefry2x32<V>(p.key0, p.key1, r0, r1);
+            typename V::vf step = V::select(inside, sigma, zero);
+            x_new = V::fmadd(step, rng::normal<V>(normal, V::to_unit(r0)), x_new);
+            y_new = V::fmadd(step, rng::normal<V>(normal, V::to_unit(r1)), y_new);
+            if constexpr (AXISYMMETRIC)
+            {
+                typename V::vi s0 = V::load_u(id + i);
+                typename V::vi s1 = V::set1_u(p.counter | 0x80000000u);
+                rng::threefry2x32<V>(p.key0, p.key1, s0, s1);
+                typename V::vf out = V::mul(step, rng::normal<V>(normal, V::to_unit(s0)));
+                typename V::vf r = V::sqrt(V::fmadd(x_new, x_new, V::mul(out, out)));
+                x_new = V::select(V::ge(x_new, zero), r, V::sub(zero, r));
+            }
+        }
+        V::store(x + i, x_new);
+        V::store(y + i, y_new);
+        // Ramo: i = q * v . E_w, with E_w at the start of the step
+        typename V::vf ewx = interpolate<V>(cell, p.weighting.fx, p.weighting.nx);
+        typename V::vf ewy = interpolate<V>(cell, p.weighting.fy, p.weighting.nx);
+        typename V::vf v_dot_ew = V::fmadd(vxi, ewx, V::mul(vyi, ewy));
+        typename V::vf wi = V::load(w + i);
+        acc = V::fmadd(v_dot_ew, wi, acc);
+        V::store(w + i, V::mul(wi, decay));
+    }
+    // the velocity already carries the sign of the charge: the Ramo current
+    // of a hole is minus its v . E_w
+    return TYPE == 0 ? V::reduce_add(acc) : -V::reduce_add(acc);
+}
+
+/**
+ * @brief run one kernel variant over [begin, end)
+ *
+ * the bulk of the range goes through the widest SIMD path available and the
+ * remainder through the scalar path
+ */
+template <int TYPE, bool DIFFUSION, bool AXISYMMETRIC>
+static float _drift(Carrier_store& store, std::size_t begin, std::size_t end, const Drift_params& p)
+{
+    std::size_t n_vec = begin + ((end - begin) / simd::Native::width) * simd::Native::width;
+    float sum = 0.;
+    sum += _drift_block<simd::Native, TYPE, DIFFUSION, AXISYMMETRIC>(store, begin, n_vec, p);
+    sum += _drift_block<simd::Scalar, TYPE, DIFFUSION, AXISYMMETRIC>(store, n_vec, end, p);
+    return sum;
+}
+
+/**
+ * @brief kernel variants of one carrier type
+ *
+ * without diffusion the drift is the same in both geometries
+ */
+template <int TYPE>
+static float _drift_species(Carrier_store& store, std::size_t begin, std::size_t end, const Drift_params& p)
+{
+    if (p.sigma > 0. && p.axisymmetric)
+        return _drift<TYPE, true, true>(store, begin, end, p);
+    if (p.sigma > 0.)
+        return _drift<TYPE, true, false>(store, begin, end, p);
+    return _drift<TYPE, false, false>(store, begin, end, p);
+}
+
+/**
+ * @brief advance carriers by one time step
+ *
+ * sets the drift velocity of carriers [begin, end) along the local field,
+ * with the speed of the v(E) table at its magnitude, or to 0 outside the
+ * field region (as update_speeds does),
+ * moves them by dt, adds the diffusion step if p.sigma > 0, scales their
+ * weights by p.decay and returns their summed contribution to the induced
+ * current. The kernel variant (carrier type, diffusion, geometry) is chosen
+ * here once per call, never per carrier
+ *
+ * @param store carriers
+ * @param begin first carrier to process
+ * @param end one past the last carrier to process
+ * @param p kernel constants (see make_drift_params)
+ *
+ * @returns sum of polarity * v . E_w * weight (1/s). Multiply by QE to get
+ *          the induced current
+ */
+float drift_kernel(Carrier_store& store, std::size_t begin, std::size_t end, const Drift_params& p)
+{
+    if (p.type == 0)
+        return _drift_species<0>(store, begin, end, p);
+    return _drift_species<1>(store, begin, end, p);
+}
@@ -0,0 +1,159 @@
+#include "electric_field.hh"
+#include "detector.hh"
+#include "poisson.hh"
+#include "profiler.hh"
+#include "resource_cache.hh"
+#include "utility.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define QE 1.602e-19
+#define EPS_0 8.854e-12
+
+// nodes along each axis. Same grid as the weighting field (see weighting_field.cc)
+static constexpr int N_NODES = 129;
+// field maps kept for reuse, enough for the biases of a sweep in flight
+static constexpr std::size_t CACHE_SIZE = 16;
+
+/**
+ * @brief hash of the parameters that determine the field
+ *
+ * FNV-1a over the model name and the bit patterns of the parameters
+ */
+static std::uint64_t _field_hash(const std::string& model, std::initializer_list<float> values)
+{
+    std::uint64_t h = 1469598103934665603ULL;
+    for (char c : model)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    for (float v : values)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        for (int k = 0; k < 4; ++k)
+        {
+            h ^= (bits >> (8*k)) & 0xFF;
+            h *= 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+/**
+ * @brief empty map on the field region of the detector
+ */
+static std::shared_ptr<Field_map> _make_map(Detector* det)
+{
+    float depth = std::min(det->get_depleted_width(), det->get_physical_width());
+    float length = det->get_physical_length();
+    return std::make_shared<Field_map>(N_NODES, N_NODES, -length/2., length/2., 0., depth);
+}
+
+/**
+ * @brief linear field on the nodes
+ */
+static std::shared_ptr<Field_map> _linear(Detector* det)
+{
+    auto map = _make_map(det);
+    int nx = map->get_nx(), ny = map->get_ny();
+    float* ex = map->fx();
+    float* ey = map->fy();
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+        {
+            ex[j*nx + i] = 0.;
+            ey[j*nx + i] = linear_field(map->get_x(i), map->get_y(j), det);
+        }
+    return map;
+}
+
+/**
+ * @brief solve the field for a doping profile
+ *
+ * solves lap(phi) = q*Nd/eps on the field region, with phi = 0 at the end
+ * of the depleted region and, at y = 0, the potential drop of the linear
+ * model (V_bias + V_bi when partially depleted, V_bias when fully
+ * depleted), and no flux through the sides. The field is -grad(phi), which
+ * for a uniform doping is the linear field
+ *
+ * @param det detector geometry and bias
+ * @param doping donor concentration at (x, y) (1/m^3)
+ *
+ * @returns field map (V/m)
+ */
+std::shared_ptr<Field_map> solve_electric_field(Detector* det, const std::function<float(float, float)>& doping)
+{
+    auto map = _make_map(det);
+    int nx = map->get_nx(), ny = map->get_ny();
+    double hx = map->get_dx(), hy = map->get_dy();
+    double depth = map->get_y(ny - 1);
+
+    // the linear field is linear in y, so its integral is exact
+    double drop = 0.5*depth*(linear_field(0., 0., det) + linear_field(0., depth, det));
+    double eps = det->get_eps()*EPS_0;
+
+    std::vector<double> phi(static_cast<std::size_t>(nx)*ny, 0.);
+    std::vector<double> rhs(phi.size(), 0.);
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+        {
+            phi[j*nx + i] = drop*(1. - static_cast<double>(j)/(ny - 1));
+            rhs[j*nx + i] = QE*doping(map->get_x(i), map->get_y(j))/eps;
+        }
+    solve_poisson(phi, rhs, nx, ny, hx, hy);
+
+    // E = -grad(phi): central differences inside, one-sided on the edges
+    float* ex = map->fx();
+    float* ey = map->fy();
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+        {
+            int i0 = std::max(i - 1, 0), i1 = std::min(i + 1, nx - 1);
+            int j0 = std::max(j - 1, 0), j1 = std::min(j + 1, ny - 1);
+            ex[j*nx + i] = -(phi[j*nx + i1] - phi[j*nx + i0])/((i1 - i0)*hx);
+            ey[j*nx + i] = -(phi[j1*nx + i] - phi[j0*nx + i])/((j1 - j0)*hy);
+        }
+    map->drop_round_off(1e-6);
+    return map;
+}
+
+/**
+ * @brief electric field of the detector
+ *
+ * builds the map of the detector field model the first time a geometry and
+ * bias are seen and returns the cached map afterwards (the CACHE_SIZE last
+ * used ones are kept). The "poisson" model
+ * uses the uniform doping of the detector. Safe to call from several threads
+ *
+ * @param det detector geometry and bias
+ *
+ * @returns field map (V/m) over [-L/2, L/2] x [0, depth]
+ */
+std::shared_ptr<const Field_map> electric_field(Detector* det)
+{
+    static Resource_cache<std::uint64_t, Field_map> cache(CACHE_SIZE);
+
+    std::string model = det->get_field_model();
+    if (model != "linear" && model != "poisson")
+        throw std::invalid_argument("electric_field: unknown field model " + model);
+    float Nd = det->get_doping_concentration();
+    std::uint64_t key = _field_hash(model, {det->get_physical_width(), det->get_physical_length(),
+                                            det->get_depleted_width(), Nd, det->get_eps(),
+                                            det->get_bias_voltage(), det->get_built_in_voltage(),
+                                            static_cast<float>(N_NODES)});
+
+    return cache.get(key, [&]() {
+        TCT_PROFILE_SCOPE("field.electric");
+        if (model == "linear")
+            return _linear(det);
+        return solve_electric_field(det, [Nd](float, float) { return Nd; });
+    });
+}
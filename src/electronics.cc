@@ -0,0 +1,236 @@
+#include "electronics.hh"
+#include "resource_cache.hh"
+#include "utility.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief filter one waveform
+ *
+ * @param in waveform of n samples
+ * @param out filtered waveform of n samples. Must not alias in
+ * @param n samples
+ */
+void Electronics_response::apply(const float* in, float* out, std::size_t n) const
+{
+    apply_batch({in}, {out}, n);
+}
+
+/**
+ * @brief class constructor
+ *
+ * @param dt sampling period (s)
+ * @param R input resistance (Ohm)
+ * @param C detector capacitance (F)
+ * @param gain scale of the output
+ */
+Rc_response::Rc_response(float dt, float R, float C, float gain)
+{
+    _alpha = R > 0 ? dt / (R*C + dt) : 1.;
+    _gain = gain;
+}
+
+void Rc_response::apply_batch(const std::vector<const float*>& in, const std::vector<float*>& out,
+                              std::size_t n) const
+{
+    for (std::size_t p = 0; p < in.size(); ++p)
+    {
+        const float* signal = in[p];
+        float* filtered = out[p];
+        if (n == 0) continue;
+        float state = _alpha * signal[0];
+        filtered[0] = _gain * state;
+        for (std::size_t i = 1; i < n; ++i)
+        {
+            state = _alpha * signal[i] + (1 - _alpha) * state;
+            filtered[i] = _gain * state;
+        }
+    }
+}
+
+/**
+ * @brief class constructor
+ *
+ * the transform size is the power of two at least twice the response, so a
+ * block of at least as many input samples as the response fits beside it
+ *
+ * @param taps impulse response, one value per sample
+ *
+ * @throws std::invalid_argument if the response is empty
+ */
+Fir_response::Fir_response(const std::vector<float>& taps)
+    : _plan(next_power_of_two(std::max<std::size_t>(64, 2*taps.size())))
+{
+    if (taps.empty()) throw std::invalid_argument("Fir_response: empty impulse response");
+    _taps = taps;
+    std::size_t N = _plan.get_size();
+    _block = N - taps.size() + 1;
+    _spectrum.assign(N, 0.);
+    for (std::size_t k = 0; k < taps.size(); ++k) _spectrum[k] = taps[k];
+    _plan.forward(_spectrum.data());
+}
+
+void Fir_response::apply_batch(const std::vector<const float*>& in, const std::vector<float*>& out,
+                               std::size_t n) const
+{
+    // the taps are real, so the real and imaginary parts of a transform
+    // carry two independent convolutions
+    std::size_t p = 0;
+    for (; p + 1 < in.size(); p += 2)
+        _convolve(in[p], in[p + 1], out[p], out[p + 1], n);
+    if (p < in.size())
+        _convolve(in[p], nullptr, out[p], nullptr, n);
+}
+
+/**
+ * @brief overlap-add convolution of one or two waveforms
+ *
+ * @param a first waveform
+ * @param b second waveform, nullptr for none
+ * @param a_out filtered a
+ * @param b_out filtered b, ignored without b
+ * @param n samples per waveform
+ */
+void Fir_response::_convolve(const float* a, const float* b, float* a_out, float* b_out, std::size_t n) const
+{
+    std::size_t N = _plan.get_size();
+    std::vector<std::complex<float>> work(N);
+    std::fill(a_out, a_out + n, 0.f);
+    if (b) std::fill(b_out, b_out + n, 0.f);
+
+    for (std::size_t start = 0; start < n; start += _block)
+    {
+        std::size_t len = std::min(_block, n - start);
+        for (std::size_t j = 0; j < len; ++j)
+            work[j] = std::complex<float>(a[start + j], b ? b[start + j] : 0.f);
+        std::fill(work.begin() + len, work.end(), std::complex<float>(0.));
+        _plan.forward(work.data());
+        multiply_spectrum(work.data(), _spectrum.data(), N);
+        _plan.inverse(work.data());
+
+        // the tail of the block overlaps the next ones
+        std::size_t end = std::min(N, n - start);
+        for (std::size_t j = 0; j < end; ++j) a_out[start + j] += work[j].real();
+        if (b)
+            for (std::size_t j = 0; j < end; ++j) b_out[start + j] += work[j].imag();
+    }
+}
+
+/**
+ * @brief scale a response to unit area times gain
+ *
+ * @throws std::invalid_argument if the response has no positive area
+ */
+static void _normalise(std::vector<float>& taps, float gain, const std::string& what)
+{
+    double area = 0.;
+    for (float h : taps) area += h;
+    if (!(area > 0.)) throw std::invalid_argument(what + ": impulse response without positive area");
+    for (float& h : taps) h = static_cast<float>(h*gain/area);
+}
+
+/**
+ * @brief impulse response of the RC stage followed by a CR-RC^n shaper
+ *
+ * the shaper response (t/tau)^n exp(-t/tau) is sampled until it decays
+ * below 1e-7 of its peak and passed through the RC stage, which is
+ * equivalent to chaining both filters. A response shorter than dt becomes
+ * a single tap
+ */
+static std::vector<float> _shaper_taps(const Simulation_params& p)
+{
+    const Electronics_params& e = p.electronics;
+    float dt = p.simulation.dt;
+    std::size_t max_taps = static_cast<std::size_t>(p.simulation.steps);
+    float peak = std::pow(static_cast<float>(e.order), e.order) * std::exp(-static_cast<float>(e.order));
+    std::vector<float> taps;
+    for (std::size_t k = 0; k < max_taps; ++k)
+    {
+        float x = k*dt/e.shaping_time;
+        float h = std::pow(x, e.order) * std::exp(-x);
+        if (x > e.order && h < 1e-7*peak) break;
+        taps.push_back(h);
+    }
+    // a shaping time much shorter than dt leaves no positive sample: the
+    // shaper is then a unit impulse on the time grid
+    if (std::none_of(taps.begin(), taps.end(), [](float h) { return h > 0.; }))
+        taps.assign(1, 1.f);
+    _normalise(taps, 1., "shaper");
+
+    // room for the RC tail, which would otherwise be cut with the taps
+    float RC = p.detector.R * p.detector.C;
+    std::size_t tail = static_cast<std::size_t>(std::ceil(16.*RC/dt));
+    taps.resize(std::min(max_taps, taps.size() + tail), 0.f);
+    std::vector<float> shaper = taps;
+    Rc_response(dt, p.detector.R, p.detector.C, e.gain).apply(shaper.data(), taps.data(), taps.size());
+    return taps;
+}
+
+/**
+ * @brief impulse response read from a file
+ *
+ * the file holds one "t,h" pair per line with increasing t. The response is
+ * resampled every dt from its first time on by linear interpolation. A
+ * relative path is taken from the project directory, as the configuration
+ *
+ * @throws std::runtime_error if the file cannot be read
+ */
+static std::vector<float> _measured_taps(const Simulation_params& p)
+{
+    const Electronics_params& e = p.electronics;
+    std::filesystem::path path = e.response_file;
+    if (path.is_relative()) path = std::filesystem::path(project_directory()) / path;
+    std::vector<float> t, h;
+    if (!readCSV(path.string(), t, h) || t.size() < 2)
+        throw std::runtime_error("could not read an impulse response from " + path.string());
+    for (std::size_t i = 1; i < t.size(); ++i)
+        if (!(t[i] > t[i - 1]))
+            throw std::runtime_error(path.string() + ": times must increase");
+
+    float dt = p.simulation.dt;
+    std::size_t n = std::min(static_cast<std::size_t>((t.back() - t.front())/dt) + 1,
+                             static_cast<std::size_t>(p.simulation.steps));
+    std::vector<float> taps(n);
+    for (std::size_t k = 0; k < n; ++k) taps[k] = linear_interpolation(t.front() + k*dt, t, h);
+    _normalise(taps, e.gain, path.string());
+    return taps;
+}
+
+// responses kept for reuse. A sweep holds its own while it runs
+static constexpr std::size_t CACHE_SIZE = 16;
+
+/**
+ * @brief response of the readout described by the parameters
+ *
+ * built the first time a set of electronics, R, C and dt is seen and cached
+ * afterwards (the CACHE_SIZE last used ones), so the response and its
+ * spectrum are computed once per run
+ *
+ * @param p parameters (electronics section, detector R and C, dt and steps)
+ *
+ * @returns the response
+ *
+ * @throws std::runtime_error if a measured response cannot be read
+ */
+std::shared_ptr<const Electronics_response> electronics_response(const Simulation_params& p)
+{
+    const Electronics_params& e = p.electronics;
+    std::ostringstream key;
+    key << std::hexfloat << e.model << ' ' << e.order << ' ' << e.shaping_time << ' ' << e.gain << ' '
+        << e.response_file << ' ' << p.detector.R << ' ' << p.detector.C << ' ' << p.simulation.dt << ' '
+        << p.simulation.steps;
+
+    static Resource_cache<std::string, Electronics_response> cache(CACHE_SIZE);
+    return cache.get(key.str(), [&]() -> std::shared_ptr<const Electronics_response> {
+        if (e.model == "shaper")
+            return std::make_shared<Fir_response>(_shaper_taps(p));
+        if (e.model == "measured")
+            return std::make_shared<Fir_response>(_measured_taps(p));
+        return std::make_shared<Rc_response>(p.simulation.dt, p.detector.R, p.detector.C, e.gain);
+    });
+}
@@ -0,0 +1,116 @@
+#include "fft.hh"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief complex product without the inf/nan recovery of operator*, which
+ * keeps the butterflies inline
+ */
+static inline std::complex<float> _mul(std::complex<float> a, std::complex<float> b)
+{
+    return {a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real()};
+}
+
+/**
+ * @brief smallest power of two not below n
+ */
+std::size_t next_power_of_two(std::size_t n)
+{
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+/**
+ * @brief class constructor
+ *
+ * @param n transform size, a power of two
+ *
+ * @throws std::invalid_argument if n is not a power of two
+ */
+Fft_plan::Fft_plan(std::size_t n)
+{
+    if (n == 0 || (n & (n - 1)) != 0)
+        throw std::invalid_argument("Fft_plan: size " + std::to_string(n) + " is not a power of two");
+    _n = n;
+
+    // twiddles in double precision, so their rounding does not build up
+    _twiddles.resize(n/2);
+    for (std::size_t k = 0; k < n/2; ++k)
+    {
+        double phase = -2.*M_PI*static_cast<double>(k)/static_cast<double>(n);
+        _twiddles[k] = std::complex<float>(std::cos(phase), std::sin(phase));
+    }
+
+    _reversed.resize(n);
+    int bits = 0;
+    while ((std::size_t(1) << bits) < n) ++bits;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::size_t r = 0;
+        for (int b = 0; b < bits; ++b)
+            if (i & (std::size_t(1) << b)) r |= std::size_t(1) << (bits - 1 - b);
+        _reversed[i] = r;
+    }
+}
+
+/**
+ * @brief forward transform, X[k] = sum x[j] exp(-2 pi i j k / n)
+ *
+ * @param data n values, replaced by their transform
+ */
+void Fft_plan::forward(std::complex<float>* data) const
+{
+    _transform(data, false);
+}
+
+/**
+ * @brief inverse transform, scaled by 1/n so that inverse(forward(x)) = x
+ *
+ * @param data n values, replaced by their inverse transform
+ */
+void Fft_plan::inverse(std::complex<float>* data) const
+{
+    _transform(data, true);
+    float scale = 1.f/static_cast<float>(_n);
+    for (std::size_t i = 0; i < _n; ++i) data[i] *= scale;
+}
+
+/**
+ * @brief iterative decimation-in-time butterflies
+ */
+void Fft_plan::_transform(std::complex<float>* data, bool inverse) const
+{
+    for (std::size_t i = 0; i < _n; ++i)
+        if (i < _reversed[i]) std::swap(data[i], data[_reversed[i]]);
+
+    for (std::size_t len = 2; len <= _n; len <<= 1)
+    {
+        std::size_t half = len/2;
+        std::size_t stride = _n/len;
+        for (std::size_t start = 0; start < _n; start += len)
+            for (std::size_t k = 0; k < half; ++k)
+            {
+                std::complex<float> w = _twiddles[k*stride];
+                if (inverse) w = std::conj(w);
+                std::complex<float> a = data[start + k];
+                std::complex<float> b = _mul(data[start + k + half], w);
+                data[start + k] = a + b;
+                data[start + k + half] = a - b;
+            }
+    }
+}
+
+/**
+ * @brief pointwise product of two spectra, data[k] *= h[k]
+ *
+ * @param data spectrum, multiplied in place
+ * @param h spectrum of the filter
+ * @param n number of frequencies
+ */
+void multiply_spectrum(std::complex<float>* data, const std::complex<float>* h, std::size_t n)
+{
+    for (std::size_t k = 0; k < n; ++k) data[k] = _mul(data[k], h[k]);
+}
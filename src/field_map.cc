@@ -0,0 +1,107 @@
+#include "field_map.hh"
+#include "simd.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief class constructor
+ *
+ * allocates a zero field on nx x ny nodes spanning [x_min, x_max] x
+ * [y_min, y_max]
+ *
+ * @param nx number of nodes along x (>= 2)
+ * @param ny number of nodes along y (>= 2)
+ * @param x_min lower x limit (m)
+ * @param x_max upper x limit (m)
+ * @param y_min lower y limit (m)
+ * @param y_max upper y limit (m)
+ */
+Field_map::Field_map(int nx, int ny, float x_min, float x_max, float y_min, float y_max)
+{
+    if (nx < 2 || ny < 2) throw std::invalid_argument("Field_map: at least 2x2 nodes required");
+    if (!(x_min < x_max) || !(y_min < y_max)) throw std::invalid_argument("Field_map: empty domain");
+    _nx = nx;
+    _ny = ny;
+    _x_min = x_min;
+    _y_min = y_min;
+    _dx = (x_max - x_min)/(nx - 1);
+    _dy = (y_max - y_min)/(ny - 1);
+    _fx.assign(static_cast<std::size_t>(nx)*ny, 0.);
+    _fy.assign(static_cast<std::size_t>(nx)*ny, 0.);
+}
+
+/**
+ * @brief field at a point
+ *
+ * @param x x coordinate (m)
+ * @param y y coordinate (m)
+ * @param fx x component at (x, y)
+ * @param fy y component at (x, y)
+ */
+void Field_map::sample(float x, float y, float& fx, float& fy) const
+{
+    // no scan for zero components: that would cost a pass over the map per
+    // point
+    bilinear<simd::Scalar>(_view(false), x, y, fx, fy);
+}
+
+/**
+ * @brief kernel view of the map
+ *
+ * a component that is 0 on every node (the x component of a field that only
+ * depends on depth) is left out of the view, so the kernels skip its lookup
+ *
+ * @returns pointers and grid constants. Valid while the map is alive
+ */
+Field_view Field_map::view() const
+{
+    return _view(true);
+}
+
+/**
+ * @brief build a view
+ *
+ * @param skip_zero leave out the components that are 0 on every node
+ */
+Field_view Field_map::_view(bool skip_zero) const
+{
+    auto is_zero = [skip_zero](const aligned_vector& f)
+    {
+        return skip_zero && std::all_of(f.begin(), f.end(), [](float a) { return a == 0.; });
+    };
+    Field_view v;
+    v.fx = is_zero(_fx) ? nullptr : _fx.data();
+    v.fy = is_zero(_fy) ? nullptr : _fy.data();
+    v.x_min = _x_min;
+    v.y_min = _y_min;
+    v.inv_dx = 1./_dx;
+    v.inv_dy = 1./_dy;
+    v.nx = _nx;
+    v.max_i = _nx - 2;
+    v.max_j = _ny - 2;
+    return v;
+}
+
+/**
+ * @brief clear components that are only round-off
+ *
+ * a component whose largest magnitude is below tolerance times the largest
+ * magnitude of the other one is set to 0, so view() leaves it out. Solved
+ * fields that do not depend on x get an exact 0 x component this way
+ *
+ * @param tolerance relative threshold
+ */
+void Field_map::drop_round_off(float tolerance)
+{
+    auto max_abs = [](const aligned_vector& f)
+    {
+        float m = 0.;
+        for (float a : f) m = std::max(m, std::abs(a));
+        return m;
+    };
+    float mx = max_abs(_fx), my = max_abs(_fy);
+    if (mx < tolerance*my) std::fill(_fx.begin(), _fx.end(), 0.f);
+    if (my < tolerance*mx) std::fill(_fy.begin(), _fy.end(), 0.f);
+}
@@ -0,0 +1,181 @@
+#include "npy.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// size of the .npy header (magic, version, length and dictionary), a multiple
+// of 64 large enough for any shape
+static constexpr std::size_t HEADER_SIZE = 128;
+
+/**
+ * @brief class constructor
+ *
+ * creates the file and writes a header for zero rows
+ *
+ * @param path output file
+ * @param row_size floats per row. 0 writes a 1D array (one float per row)
+ *
+ * @throws std::runtime_error if the file cannot be created
+ */
+Npy_writer::Npy_writer(const std::string& path, std::size_t row_size)
+{
+    _path = path;
+    _row_size = row_size;
+    _rows = 0;
+    _bytes = 0;
+    _file.open(path, std::ios::binary | std::ios::trunc);
+    if (!_file.is_open()) throw std::runtime_error("Npy_writer: could not create " + path);
+    _write_header();
+}
+
+/**
+ * @brief class destructor. Closes the file if still open
+ */
+Npy_writer::~Npy_writer()
+{
+    try {
+        close();
+    }
+    catch (...) {
+    }
+}
+
+/**
+ * @brief write the header for the current number of rows
+ */
+void Npy_writer::_write_header()
+{
+    std::string shape = "(" + std::to_string(_rows) + (_row_size ? ", " + std::to_string(_row_size) + ")" : ",)");
+    std::string dict = "{'descr': '<f4', 'fortran_order': False, 'shape': " + shape + ", }";
+    std::size_t dict_size = HEADER_SIZE - 10;
+    dict.resize(dict_size - 1, ' ');
+    dict += '\n';
+
+    char preamble[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                         static_cast<char>(dict_size & 0xFF), static_cast<char>(dict_size >> 8)};
+    _file.seekp(0);
+    _file.write(preamble, sizeof(preamble));
+    _file.write(dict.data(), dict.size());
+    if (_bytes == 0) _bytes = HEADER_SIZE;
+}
+
+/**
+ * @brief append one row
+ *
+ * @param row row_size floats (one for a 1D array)
+ */
+void Npy_writer::write_row(const float* row)
+{
+    static_assert(sizeof(float) == 4, "npy output assumes 32-bit floats");
+    std::size_t n = _row_size ? _row_size : 1;
+    _file.write(reinterpret_cast<const char*>(row), n*sizeof(float));
+    if (!_file) throw std::runtime_error("Npy_writer: write failed on " + _path);
+    ++_rows;
+    _bytes += n*sizeof(float);
+}
+
+/**
+ * @brief finish the file
+ *
+ * patches the shape in the header with the number of rows written and
+ * closes the file
+ */
+void Npy_writer::close()
+{
+    if (!_file.is_open()) return;
+    _file.seekp(0, std::ios::end);
+    std::streampos end = _file.tellp();
+    _write_header();
+    _file.seekp(end);
+    _file.close();
+}
+
+/**
+ * @brief class constructor
+ *
+ * maps the file and parses its header
+ *
+ * @param path .npy file
+ *
+ * @throws std::runtime_error if the file cannot be mapped or does not hold a
+ *         float32/float64 array in C order
+ */
+Npy_array::Npy_array(const std::string& path)
+{
+    _map = MAP_FAILED;
+    _map_size = 0;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Npy_array: could not open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        _map_size = static_cast<std::size_t>(st.st_size);
+        _map = ::mmap(nullptr, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (_map == MAP_FAILED) throw std::runtime_error("Npy_array: could not map " + path);
+
+    // the map is released by the destructor only once the object is built
+    try {
+        const char* bytes = static_cast<const char*>(_map);
+        if (_map_size < 10 || std::memcmp(bytes, "\x93NUMPY", 6) != 0)
+            throw std::runtime_error("Npy_array: " + path + " is not a .npy file");
+        // version 1 has a 16-bit header length, versions 2 and 3 a 32-bit one
+        std::size_t header_start = bytes[6] == 1 ? 10 : 12;
+        std::size_t header_size = static_cast<unsigned char>(bytes[8]) | static_cast<unsigned char>(bytes[9]) << 8;
+        if (bytes[6] != 1)
+            header_size |= static_cast<std::size_t>(static_cast<unsigned char>(bytes[10])) << 16 |
+                           static_cast<std::size_t>(static_cast<unsigned char>(bytes[11])) << 24;
+        if (header_start + header_size > _map_size)
+            throw std::runtime_error("Npy_array: truncated header in " + path);
+        std::string header(bytes + header_start, header_size);
+
+        if (header.find("'descr': '<f8'") != std::string::npos)
+            _double = true;
+        else if (header.find("'descr': '<f4'") != std::string::npos)
+            _double = false;
+        else
+            throw std::runtime_error("Npy_array: " + path + " does not hold little-endian float32 or float64 values");
+        if (header.find("'fortran_order': False") == std::string::npos)
+            throw std::runtime_error("Npy_array: " + path + " is not in C order");
+
+        std::size_t shape_begin = header.find("'shape': (");
+        std::size_t shape_end = header.find(')', shape_begin);
+        if (shape_begin == std::string::npos || shape_end == std::string::npos)
+            throw std::runtime_error("Npy_array: no shape in " + path);
+        _size = 1;
+        const char* c = header.c_str() + shape_begin + 10;
+        const char* end = header.c_str() + shape_end;
+        while (c < end)
+        {
+            char* next;
+            unsigned long long n = std::strtoull(c, &next, 10);
+            if (next == c) {++c; continue;}
+            _shape.push_back(static_cast<std::size_t>(n));
+            _size *= n;
+            c = next;
+        }
+
+        _values = bytes + header_start + header_size;
+        if (_values + _size*(_double ? sizeof(double) : sizeof(float)) > bytes + _map_size)
+            throw std::runtime_error("Npy_array: " + path + " is shorter than its shape");
+    }
+    catch (...) {
+        ::munmap(_map, _map_size);
+        throw;
+    }
+}
+
+/**
+ * @brief class destructor. Releases the map
+ */
+Npy_array::~Npy_array()
+{
+    ::munmap(_map, _map_size);
+}
@@ -0,0 +1,52 @@
+#include "plotting.hh"
+#include "utility.hh"
+
+#include <vector>
+
+/**
+ * @brief plot electric field in the x-y plane
+ * 
+ * this function can be invoked to visualize the electric field inside the 
+ * detector as a 2D map
+ * 
+ * @param x_min lower x limit (m)
+ * @param x_max upper x limit (m)
+ * @param nx number of points along x axis
+ * @param y_min lower y limit (m)
+ * @param y_max upper y limit (m)
+ * @param ny number of points along y axis
+ * @param det detector geometry
+ * 
+ * @returns ROOT TH2F histogram with the plot
+ */
+TH2F* plot_E_field(float x_min, float x_max, int nx, float y_min, float y_max, int ny, Detector* det)
+{
+    std::vector<float> x_vals;
+    std::vector<float> y_vals;
+    for(int i = 0; i < nx; ++i)
+    {
+        x_vals.push_back(x_min + i*x_max/nx);
+    }
+    for(int i = 0; i < ny; ++i)
+    {
+        y_vals.push_back(y_min + i*y_max/ny);
+    }
+
+    TH2F* hE = new TH2F("hE", "Electric Field Magnitude; x [m]; y [m]; E[V/m]",
+                        nx, x_min, x_max,
+                        ny, y_min, y_max);
+
+    // Fill the histogram
+    for (int i = 0; i < nx; ++i)
+    {
+        for (int j = 0; j < ny; ++j)
+        {
+            float x = x_vals[i];
+            float y = y_vals[j];
+            float E = linear_field(x, y, det);
+            hE->SetBinContent(i + 1, j + 1, E);
+        }
+    }
+
+    return hE;
+}
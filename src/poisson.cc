@@ -0,0 +1,222 @@
+#include "poisson.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief mirrored x index for the Neumann edges
+ */
+static inline int _mirror(int i, int nx)
+{
+    if (i < 0) return -i;
+    if (i >= nx) return 2*(nx - 1) - i;
+    return i;
+}
+
+/**
+ * @brief red-black Gauss-Seidel sweeps on the interior rows
+ */
+static void _smooth(std::vector<double>& u, const std::vector<double>& f, int nx, int ny,
+                    double hx, double hy, int sweeps)
+{
+    double cx = 1./(hx*hx), cy = 1./(hy*hy);
+    double diag = 2.*(cx + cy);
+    for (int s = 0; s < sweeps; ++s)
+        for (int colour = 0; colour < 2; ++colour)
+            for (int j = 1; j < ny - 1; ++j)
+                for (int i = (j + colour) % 2; i < nx; i += 2)
+                {
+                    double lr = u[j*nx + _mirror(i - 1, nx)] + u[j*nx + _mirror(i + 1, nx)];
+                    double ud = u[(j - 1)*nx + i] + u[(j + 1)*nx + i];
+                    u[j*nx + i] = (cx*lr + cy*ud - f[j*nx + i])/diag;
+                }
+}
+
+/**
+ * @brief residual rhs - lap(u), zero on the Dirichlet rows
+ */
+static void _residual(const std::vector<double>& u, const std::vector<double>& f, std::vector<double>& r,
+                      int nx, int ny, double hx, double hy)
+{
+    double cx = 1./(hx*hx), cy = 1./(hy*hy);
+    r.assign(static_cast<std::size_t>(nx)*ny, 0.);
+    for (int j = 1; j < ny - 1; ++j)
+        for (int i = 0; i < nx; ++i)
+        {
+            double lap = cx*(u[j*nx + _mirror(i - 1, nx)] - 2*u[j*nx + i] + u[j*nx + _mirror(i + 1, nx)])
+                       + cy*(u[(j - 1)*nx + i] - 2*u[j*nx + i] + u[(j + 1)*nx + i]);
+            r[j*nx + i] = f[j*nx + i] - lap;
+        }
+}
+
+/**
+ * @brief one V-cycle
+ *
+ * the grid is coarsened while both node counts stay odd and larger than 3;
+ * the coarsest level is solved by plain smoothing
+ */
+static void _v_cycle(std::vector<double>& u, const std::vector<double>& f, int nx, int ny, double hx, double hy)
+{
+    bool coarsen = nx > 3 && ny > 3 && nx % 2 == 1 && ny % 2 == 1;
+    if (!coarsen)
+    {
+        _smooth(u, f, nx, ny, hx, hy, 200);
+        return;
+    }
+
+    _smooth(u, f, nx, ny, hx, hy, 3);
+
+    std::vector<double> r;
+    _residual(u, f, r, nx, ny, hx, hy);
+
+    // full weighting restriction, mirrored at the x edges
+    int cnx = (nx - 1)/2 + 1, cny = (ny - 1)/2 + 1;
+    std::vector<double> rc(static_cast<std::size_t>(cnx)*cny, 0.);
+    for (int J = 1; J < cny - 1; ++J)
+        for (int I = 0; I < cnx; ++I)
+        {
+            int i = 2*I, j = 2*J;
+            double s = 0.;
+            for (int dj = -1; dj <= 1; ++dj)
+                for (int di = -1; di <= 1; ++di)
+                {
+                    double w = (di == 0 ? 2. : 1.)*(dj == 0 ? 2. : 1.);
+                    s += w*r[(j + dj)*nx + _mirror(i + di, nx)];
+                }
+            rc[J*cnx + I] = s/16.;
+        }
+
+    // the error vanishes on the Dirichlet rows
+    std::vector<double> ec(static_cast<std::size_t>(cnx)*cny, 0.);
+    _v_cycle(ec, rc, cnx, cny, 2*hx, 2*hy);
+
+    // bilinear prolongation of the correction
+    for (int j = 1; j < ny - 1; ++j)
+        for (int i = 0; i < nx; ++i)
+        {
+            int I = i/2, J = j/2;
+            double tx = (i % 2)*0.5, ty = (j % 2)*0.5;
+            int I1 = std::min(I + 1, cnx - 1), J1 = std::min(J + 1, cny - 1);
+            double e = (1 - tx)*(1 - ty)*ec[J*cnx + I] + tx*(1 - ty)*ec[J*cnx + I1]
+                     + (1 - tx)*ty*ec[J1*cnx + I] + tx*ty*ec[J1*cnx + I1];
+            u[j*nx + i] += e;
+        }
+
+    _smooth(u, f, nx, ny, hx, hy, 3);
+}
+
+/**
+ * @brief solve the Poisson equation
+ *
+ * @param phi potential on nx x ny nodes, row-major in y. Rows 0 and ny - 1
+ *            hold the Dirichlet values; the rest is the initial guess and is
+ *            overwritten with the solution
+ * @param rhs right hand side (same layout). Only interior rows are used
+ * @param nx number of nodes along x
+ * @param ny number of nodes along y
+ * @param hx node spacing along x
+ * @param hy node spacing along y
+ * @param tol convergence threshold on the max residual, relative to the
+ *            largest of the residual of the initial guess and 1
+ * @param max_cycles maximum number of V-cycles
+ */
+void solve_poisson(std::vector<double>& phi, const std::vector<double>& rhs, int nx, int ny,
+                   double hx, double hy, double tol, int max_cycles)
+{
+    if (nx < 2 || ny < 3) throw std::invalid_argument("solve_poisson: grid too small");
+    if (phi.size() != static_cast<std::size_t>(nx)*ny || rhs.size() != phi.size())
+        throw std::invalid_argument("solve_poisson: size mismatch");
+
+    std::vector<double> r;
+    auto max_residual = [&]()
+    {
+        _residual(phi, rhs, r, nx, ny, hx, hy);
+        double m = 0.;
+        for (double v : r) m = std::max(m, std::abs(v));
+        return m;
+    };
+    double scale = std::max(max_residual(), 1.);
+    for (int c = 0; c < max_cycles; ++c)
+    {
+        _v_cycle(phi, rhs, nx, ny, hx, hy);
+        if (max_residual() < tol*scale) return;
+    }
+}
+
+/**
+ * @brief solve the axisymmetric Poisson equation
+ *
+ * solves (1/r) d/dr(r dphi/dr) + d2phi/dy2 = rhs with r_i = i*hr measured
+ * from the axis. Each sweep solves every column exactly for the current
+ * values of its neighbours (Thomas algorithm) and over-relaxes the update,
+ * which keeps converging when hy is much smaller than hr (thin sensors)
+ *
+ * @param phi potential on nr x ny nodes, row-major in y (column 0 on the
+ *            axis). Rows 0 and ny - 1 hold the Dirichlet values; the rest
+ *            is the initial guess and is overwritten with the solution
+ * @param rhs right hand side (same layout). Only interior rows are used
+ * @param nr number of nodes along r
+ * @param ny number of nodes along y
+ * @param hr node spacing along r
+ * @param hy node spacing along y
+ * @param tol convergence threshold on the largest update of a sweep,
+ *            relative to the largest of |phi| and 1
+ * @param max_sweeps maximum number of sweeps
+ */
+void solve_poisson_axisymmetric(std::vector<double>& phi, const std::vector<double>& rhs, int nr, int ny,
+                                double hr, double hy, double tol, int max_sweeps)
+{
+    if (nr < 2 || ny < 3) throw std::invalid_argument("solve_poisson_axisymmetric: grid too small");
+    if (phi.size() != static_cast<std::size_t>(nr)*ny || rhs.size() != phi.size())
+        throw std::invalid_argument("solve_poisson_axisymmetric: size mismatch");
+
+    // couplings of column i to its inner and outer neighbours. On the axis
+    // the Laplacian is 2 d2/dr2; the outer column mirrors its inner one
+    std::vector<double> inner(nr), outer(nr);
+    for (int i = 0; i < nr; ++i)
+    {
+        if (i == 0) {inner[i] = 0.; outer[i] = 4./(hr*hr);}
+        else if (i == nr - 1) {inner[i] = 2./(hr*hr); outer[i] = 0.;}
+        else {inner[i] = (1. - 0.5/i)/(hr*hr); outer[i] = (1. + 0.5/i)/(hr*hr);}
+    }
+    double cy = 1./(hy*hy);
+    double omega = 2./(1. + std::sin(M_PI/nr));
+
+    double scale = 1.;
+    for (double v : phi) scale = std::max(scale, std::abs(v));
+    std::vector<double> c(ny), d(ny);
+    for (int sweep = 0; sweep < max_sweeps; ++sweep)
+    {
+        double change = 0.;
+        for (int i = 0; i < nr; ++i)
+        {
+            // cy u[j-1] - diag u[j] + cy u[j+1] = d[j], forward elimination
+            double diag = inner[i] + outer[i] + 2.*cy;
+            c[0] = 0.;
+            d[0] = phi[i];
+            for (int j = 1; j < ny - 1; ++j)
+            {
+                double b = rhs[j*nr + i];
+                if (i > 0) b -= inner[i]*phi[j*nr + i - 1];
+                if (i < nr - 1) b -= outer[i]*phi[j*nr + i + 1];
+                if (j == ny - 2) b -= cy*phi[(ny - 1)*nr + i];
+                double m = -diag - cy*c[j - 1];
+                c[j] = cy/m;
+                d[j] = (b - cy*d[j - 1])/m;
+            }
+            // back substitution with over-relaxation
+            double next = phi[(ny - 1)*nr + i];
+            for (int j = ny - 2; j >= 1; --j)
+            {
+                double u = j == ny - 2 ? d[j] : d[j] - c[j]*next;
+                double& old = phi[j*nr + i];
+                double updated = old + omega*(u - old);
+                change = std::max(change, std::abs(updated - old));
+                old = updated;
+                next = u;
+            }
+        }
+        if (change < tol*scale) return;
+    }
+}
@@ -0,0 +1,225 @@
+#include "profiler.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+// events kept per thread for the trace. Later ones are counted as dropped
+static constexpr std::size_t MAX_EVENTS = 1 << 20;
+
+struct Phase_stat
+{
+    std::uint64_t calls = 0;
+    double total = 0.;  // (s)
+    double max = 0.;    // (s)
+};
+
+struct Counter_stat
+{
+    std::uint64_t count = 0;
+    double sum = 0.;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+};
+
+struct Trace_event
+{
+    const char* name;
+    double start;       // since the epoch (us)
+    double duration;    // (us)
+};
+
+/**
+ * @brief what one thread recorded
+ */
+struct Thread_log
+{
+    int tid;
+    std::unordered_map<const char*, Phase_stat> phases;
+    std::unordered_map<const char*, Counter_stat> counters;
+    std::vector<Trace_event> events;
+    std::uint64_t dropped = 0;
+};
+
+// the logs outlive their threads, so the pool workers are reported too
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<Thread_log>> registry;
+static std::atomic<bool> trace_enabled{false};
+static clock_type::time_point epoch = clock_type::now();
+
+/**
+ * @brief log of the calling thread, registered on first use
+ */
+static Thread_log& _log()
+{
+    thread_local Thread_log* log = nullptr;
+    if (!log)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.emplace_back(new Thread_log);
+        log = registry.back().get();
+        log->tid = static_cast<int>(registry.size()) - 1;
+    }
+    return *log;
+}
+
+/**
+ * @brief class constructor. Starts the clock
+ *
+ * @param name phase, a string literal
+ */
+Profile_scope::Profile_scope(const char* name)
+{
+    _name = name;
+    _start = clock_type::now();
+}
+
+/**
+ * @brief class destructor. Adds the elapsed time to the phase
+ */
+Profile_scope::~Profile_scope()
+{
+    clock_type::time_point end = clock_type::now();
+    double seconds = std::chrono::duration<double>(end - _start).count();
+    Thread_log& log = _log();
+    Phase_stat& s = log.phases[_name];
+    ++s.calls;
+    s.total += seconds;
+    s.max = std::max(s.max, seconds);
+    if (trace_enabled.load(std::memory_order_relaxed))
+    {
+        if (log.events.size() < MAX_EVENTS)
+            log.events.push_back({_name, std::chrono::duration<double, std::micro>(_start - epoch).count(),
+                                  seconds*1e6});
+        else
+            ++log.dropped;
+    }
+}
+
+/**
+ * @brief record one value of a counter
+ *
+ * @param name counter, a string literal
+ * @param value value
+ */
+void profile_count(const char* name, double value)
+{
+    Counter_stat& c = _log().counters[name];
+    ++c.count;
+    c.sum += value;
+    c.min = std::min(c.min, value);
+    c.max = std::max(c.max, value);
+}
+
+/**
+ * @brief forget everything recorded so far
+ */
+void profile_reset()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& log : registry)
+    {
+        log->phases.clear();
+        log->counters.clear();
+        log->events.clear();
+        log->dropped = 0;
+    }
+    epoch = clock_type::now();
+}
+
+/**
+ * @brief keep every scope as a trace event from now on
+ *
+ * @param enable true to record events
+ */
+void profile_enable_trace(bool enable)
+{
+    trace_enabled = enable;
+}
+
+/**
+ * @brief merged statistics of all threads
+ *
+ * @returns json with "phases" (calls, total_s, mean_s, max_s) and "counters"
+ *          (count, sum, mean, min, max), by name
+ */
+nlohmann::json profile_report()
+{
+    std::map<std::string, Phase_stat> phases;
+    std::map<std::string, Counter_stat> counters;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& log : registry)
+        {
+            for (const auto& [name, s] : log->phases)
+            {
+                Phase_stat& m = phases[name];
+                m.calls += s.calls;
+                m.total += s.total;
+                m.max = std::max(m.max, s.max);
+            }
+            for (const auto& [name, c] : log->counters)
+            {
+                Counter_stat& m = counters[name];
+                m.count += c.count;
+                m.sum += c.sum;
+                m.min = std::min(m.min, c.min);
+                m.max = std::max(m.max, c.max);
+            }
+        }
+    }
+
+    nlohmann::json report;
+    report["phases"] = nlohmann::json::object();
+    report["counters"] = nlohmann::json::object();
+    for (const auto& [name, s] : phases)
+        report["phases"][name] = {{"calls", s.calls}, {"total_s", s.total},
+                                  {"mean_s", s.total/s.calls}, {"max_s", s.max}};
+    for (const auto& [name, c] : counters)
+        report["counters"][name] = {{"count", c.count}, {"sum", c.sum}, {"mean", c.sum/c.count},
+                                    {"min", c.min}, {"max", c.max}};
+    return report;
+}
+
+/**
+ * @brief write the recorded events as a Chrome trace
+ *
+ * one complete event ("ph": "X") per scope, one track per thread
+ *
+ * @param path output file
+ *
+ * @throws std::runtime_error if the file cannot be written
+ */
+void write_profile_trace(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw std::runtime_error("Could not open output file: " + path);
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::uint64_t dropped = 0;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& log : registry)
+    {
+        dropped += log->dropped;
+        out << (first ? "\n" : ",\n") << nlohmann::json{{"name", "thread_name"}, {"ph", "M"}, {"pid", 1},
+                                                          {"tid", log->tid},
+                                                          {"args", {{"name", "thread " + std::to_string(log->tid)}}}}.dump();
+        first = false;
+        // written by hand: a json object per event would dominate the cost
+        for (const Trace_event& e : log->events)
+            out << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << log->tid
+                << ", \"ts\": " << e.start << ", \"dur\": " << e.duration << "}";
+    }
+    out << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+}
@@ -0,0 +1,198 @@
+#include "pulse.hh"
+#include "beam_profile.hh"
+#include "charge_injection.hh"
+#include "transport_engine.hh"
+#include "analytic_engine.hh"
+#include "profiler.hh"
+#include "readout.hh"
+#include "utility.hh"
+
+#include <memory>
+#include <stdexcept>
+
+/**
+ * @brief transport the carriers of one pulse
+ *
+ * runs the engine selected by simulation.engine (the stepped
+ * Transport_engine or the Analytic_engine) for the configured number of steps,
+ * or until all the charge is collected, and applies the readout
+ *
+ * @returns the simulated pulse
+ */
+static Pulse _transport(Charge_injection& injection_e, Charge_injection& injection_h, float focus,
+                        const Simulation_params& par, Detector* det, std::uint64_t seed, Thread_pool* pool)
+{
+    TCT_PROFILE_SCOPE("pulse");
+    int steps = par.simulation.steps;
+    float dt = par.simulation.dt;
+
+    Pulse pulse;
+    pulse.focus = focus;
+    pulse.signal_e.assign(steps, 0.0f);
+    pulse.signal_h.assign(steps, 0.0f);
+    pulse.signal_total.assign(steps, 0.0f);
+    if (par.simulation.engine == "analytic")
+    {
+        Analytic_engine engine(injection_e, injection_h, det);
+        engine.set_trapping(par.simulation.trapping);
+        engine.run(dt, steps, pulse.signal_e, pulse.signal_h);
+        for(int step = 0; step < steps; ++step)
+            pulse.signal_total[step] = pulse.signal_e[step] + pulse.signal_h[step];
+    }
+    else
+    {
+        Transport_engine engine(injection_e, injection_h, det, pool);
+        engine.set_diffusion(par.simulation.diffusion, seed);
+        engine.set_trapping(par.simulation.trapping);
+        // the waveform is zero-filled after all charge has been collected
+        for(int step = 0; step < steps && !engine.is_done(); ++step)
+        {
+            Step_current current = engine.step(dt);
+            pulse.signal_e[step] = current.e;
+            pulse.signal_h[step] = current.h;
+            pulse.signal_total[step] = current.e + current.h;
+        }
+    }
+
+    apply_readout(pulse, *electronics_response(par), dt, par.simulation.t_pc);
+    return pulse;
+}
+
+/**
+ * @brief apply the readout to a batch of pulses
+ *
+ * fills the filtered waveform, the collected charge and the WPC from the
+ * induced current. Only depends on the current and the readout, so a pulse
+ * can be read out again with another R or t_pc without transporting it. The
+ * pulses of a batch go through the response together (see
+ * Electronics_response::apply_batch)
+ *
+ * @param pulses pulses with their induced current filled, all of the same
+ *               length
+ * @param electronics readout response
+ * @param dt time step (s)
+ * @param t_pc time of the WPC sample (s)
+ *
+ * @throws std::invalid_argument if the pulses differ in length
+ */
+void apply_readout(const std::vector<Pulse*>& pulses, const Electronics_response& electronics, float dt, float t_pc)
+{
+    if (pulses.empty()) return;
+    TCT_PROFILE_SCOPE("readout");
+    std::size_t steps = pulses[0]->signal_total.size();
+    std::vector<const float*> in;
+    std::vector<float*> out;
+    for (Pulse* pulse : pulses)
+    {
+        if (pulse->signal_total.size() != steps)
+            throw std::invalid_argument("apply_readout: pulses of a batch must have the same length");
+        pulse->filtered.assign(steps, 0.0f);
+        in.push_back(pulse->signal_total.data());
+        out.push_back(pulse->filtered.data());
+    }
+    {
+        TCT_PROFILE_SCOPE("readout.filter");
+        electronics.apply_batch(in, out, steps);
+    }
+
+    std::vector<float> t(steps);
+    for(std::size_t i = 0; i < steps; ++i) t[i] = i * dt;
+    for (Pulse* pulse : pulses)
+    {
+        pulse->charge = integrate_charge(pulse->signal_total, dt);
+        pulse->WPC = steps ? linear_interpolation(t_pc, t, pulse->filtered) : 0.f;
+    }
+}
+
+/**
+ * @brief apply the readout to a pulse
+ *
+ * @param pulse pulse with its induced current filled
+ * @param electronics readout response
+ * @param dt time step (s)
+ * @param t_pc time of the WPC sample (s)
+ */
+void apply_readout(Pulse& pulse, const Electronics_response& electronics, float dt, float t_pc)
+{
+    apply_readout(std::vector<Pulse*>{&pulse}, electronics, dt, t_pc);
+}
+
+/**
+ * @brief simulate one pulse
+ *
+ * injects electrons and holes with the laser focused at the given depth and
+ * transports them. With a beam profile the carriers are drawn from the
+ * table (see beam_profile.hh). Only reads from par and det, so it can run
+ * concurrently for several focus positions
+ *
+ * @param focus depth at which the laser is focused (m)
+ * @param par simulation parameters
+ * @param det detector geometry
+ * @param seed seed of the injection sampling and of the diffusion
+ * @param pool threads shared by the carriers of this pulse. nullptr runs the
+ *             transport on the calling thread
+ *
+ * @returns the simulated pulse
+ */
+Pulse simulate_pulse(float focus, const Simulation_params& par, Detector* det, std::uint64_t seed, Thread_pool* pool)
+{
+    if (std::shared_ptr<const Beam_profile> profile = beam_profile(par))
+        return simulate_pulse(Beam_template(*profile, par.injection.N, seed), focus, par, det, seed, pool);
+
+    Charge_injection injection_e(focus,
+                                 par.injection.wavelength,
+                                 par.injection.NA,
+                                 par.injection.refractive_index,
+                                 det,
+                                 0,
+                                 par.injection.N,
+                                 seed,
+                                 par.injection.importance_fraction);
+    Charge_injection injection_h = injection_e;
+    injection_h.set_type(1);
+    return _transport(injection_e, injection_h, focus, par, det, seed, pool);
+}
+
+/**
+ * @brief simulate one pulse from a beam template
+ *
+ * same as above, but the carriers are the template translated to the focus,
+ * so several pulses share one sampled beam
+ *
+ * @param beam carriers sampled around the focus
+ * @param focus depth at which the laser is focused (m)
+ * @param par simulation parameters
+ * @param det detector geometry
+ * @param seed seed of the diffusion
+ * @param pool threads shared by the carriers of this pulse. nullptr runs the
+ *             transport on the calling thread
+ *
+ * @returns the simulated pulse
+ */
+Pulse simulate_pulse(const Beam_template& beam, float focus, const Simulation_params& par, Detector* det,
+                     std::uint64_t seed, Thread_pool* pool)
+{
+    Charge_injection injection_e(beam, focus, det, 0);
+    Charge_injection injection_h(beam, focus, det, 1);
+    return _transport(injection_e, injection_h, focus, par, det, seed, pool);
+}
+
+/**
+ * @brief derive the seed of one scan point
+ *
+ * mixes the master seed and the index of the point with splitmix64 so every
+ * point gets an independent, reproducible stream whatever the order in which
+ * points are executed
+ *
+ * @param master master seed (simulation.seed)
+ * @param index index of the scan point
+ *
+ * @returns seed of the point
+ */
+std::uint64_t derive_seed(std::uint64_t master, std::uint64_t index)
+{
+    std::uint64_t z = master + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,69 @@
+#include "random.hh"
+
+#include <cmath>
+
+/**
+ * @brief standard normal CDF
+ */
+static double _normal_cdf(double x)
+{
+    return 0.5*std::erfc(-x/std::sqrt(2.));
+}
+
+/**
+ * @brief standard normal inverse CDF
+ *
+ * bisection on the CDF. Only used to build the table
+ */
+static double _normal_quantile(double p)
+{
+    double lo = -10., hi = 10.;
+    for (int i = 0; i < 100; ++i)
+    {
+        double mid = 0.5*(lo + hi);
+        if (_normal_cdf(mid) < p) lo = mid;
+        else hi = mid;
+    }
+    return 0.5*(lo + hi);
+}
+
+/**
+ * @brief inverse normal CDF table
+ *
+ * built on first use. The end nodes are evaluated half a bin inside (0, 1),
+ * which cuts the tails at about 3.5 sigma, and the whole table is then
+ * rescaled so the deviates it produces have unit variance
+ *
+ * @returns the shared table
+ */
+const rng::Normal_table& rng::normal_table()
+{
+    static const Normal_table table = []()
+    {
+        Normal_table t;
+        const int n = Normal_table::n_bins;
+        double g[n + 1];
+        for (int i = 0; i <= n; ++i)
+        {
+            double p = static_cast<double>(i)/n;
+            if (i == 0) p = 0.5/n;
+            if (i == n) p = 1. - 0.5/n;
+            g[i] = _normal_quantile(p);
+        }
+
+        // variance of the piecewise linear deviate: mean over the bins of
+        // int_0^1 (a + s*(b - a))^2 ds
+        double var = 0.;
+        for (int i = 0; i < n; ++i)
+            var += (g[i]*g[i] + g[i]*g[i+1] + g[i+1]*g[i+1])/3.;
+        double scale = 1./std::sqrt(var/n);
+
+        for (int i = 0; i <= n; ++i)
+            t.g[i] = g[i]*scale;
+        for (int i = 0; i < n; ++i)
+            t.dg[i] = t.g[i+1] - t.g[i];
+        t.dg[n] = 0.;
+        return t;
+    }();
+    return table;
+}
@@ -0,0 +1,40 @@
+#include "readout.hh"
+#include "electronics.hh"
+
+/**
+ * @brief first order RC low-pass filter
+ *
+ * models the readout electronics as a single RC stage. If R is not positive
+ * the signal is returned unfiltered
+ *
+ * @param signal induced current sampled every dt (A)
+ * @param dt sampling period (s)
+ * @param R input resistance (Ohm)
+ * @param C detector capacitance (F)
+ *
+ * @returns filtered pulse, same length as the input
+ */
+std::vector<float> rc_filter(const std::vector<float>& signal, float dt, float R, float C)
+{
+    std::vector<float> filtered(signal.size());
+    Rc_response(dt, R, C).apply(signal.data(), filtered.data(), signal.size());
+    return filtered;
+}
+
+/**
+ * @brief integrate a current pulse
+ *
+ * trapezoidal integration of a pulse sampled every dt
+ *
+ * @param signal current (A)
+ * @param dt sampling period (s)
+ *
+ * @returns collected charge (C)
+ */
+float integrate_charge(const std::vector<float>& signal, float dt)
+{
+    float Q_t = 0.0;
+    for (std::size_t i = 1; i < signal.size(); ++i)
+        Q_t += 0.5*(signal[i] + signal[i-1])*dt;
+    return Q_t;
+}
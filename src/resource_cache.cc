@@ -0,0 +1,50 @@
+#include "resource_cache.hh"
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief every live cache
+ *
+ * function-static, so it is built before the first cache registers and
+ * destroyed after the last one
+ */
+static std::pair<std::mutex, std::vector<Resource_cache_base*>>& _registry()
+{
+    static std::pair<std::mutex, std::vector<Resource_cache_base*>> registry;
+    return registry;
+}
+
+/**
+ * @brief registers the cache
+ */
+Resource_cache_base::Resource_cache_base()
+{
+    auto& [mutex, caches] = _registry();
+    std::lock_guard<std::mutex> lock(mutex);
+    caches.push_back(this);
+}
+
+/**
+ * @brief unregisters the cache
+ */
+Resource_cache_base::~Resource_cache_base()
+{
+    auto& [mutex, caches] = _registry();
+    std::lock_guard<std::mutex> lock(mutex);
+    caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+}
+
+/**
+ * @brief empty every resource cache
+ *
+ * resources still held by a caller stay alive until it drops them. Safe to
+ * call while simulations run: they rebuild what they need
+ */
+void clear_resource_caches()
+{
+    auto& [mutex, caches] = _registry();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Resource_cache_base* cache : caches)
+        cache->clear();
+}
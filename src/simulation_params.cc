@@ -0,0 +1,522 @@
+#include "simulation_params.hh"
+#include "detector.hh"
+#include "material.hh"
+
+#include <limits>
+#include <set>
+#include <sstream>
+#include <type_traits>
+
+using json = nlohmann::json;
+
+/**
+ * @brief class constructor
+ *
+ * @param problems one line per problem found in the configuration
+ */
+Config_error::Config_error(const std::vector<std::string>& problems)
+    : std::invalid_argument([&problems]()
+    {
+        std::string report = "invalid configuration (" + std::to_string(problems.size()) + " problems):";
+        for (const std::string& p : problems) report += "\n  " + p;
+        return report;
+    }())
+{
+    _problems = problems;
+}
+
+/**
+ * @brief reader of one section of the configuration
+ *
+ * reads typed values, checks their ranges and records every problem instead
+ * of throwing, so the whole file is checked in one pass. Keys that are never
+ * read are reported as unknown (usually a typo)
+ */
+class Section_reader
+{
+    public:
+        Section_reader(const json& data, const std::string& section, std::vector<std::string>& problems)
+            : _section(section), _problems(problems)
+        {
+            if (!data.contains(section))
+                _problem("missing section");
+            else if (!data[section].is_object())
+                _problem("not an object");
+            else
+                _data = &data[section];
+        }
+
+        /**
+         * @brief number in [lo, hi]
+         *
+         * @param key name of the value
+         * @param fallback default. nullptr makes the key required
+         * @param lo lowest accepted value
+         * @param hi highest accepted value
+         * @param unit unit quoted in the report
+         */
+        template <class T>
+        T number(const char* key, const T* fallback, T lo, T hi, const char* unit)
+        {
+            T value = fallback ? *fallback : T{};
+            const json* item = _find(key, fallback == nullptr);
+            if (!item) return value;
+            if (!item->is_number())
+            {
+                _problem(std::string(key) + ": expected a number, got " + item->dump());
+                return value;
+            }
+            if (std::is_integral<T>::value && !item->is_number_integer())
+            {
+                _problem(std::string(key) + ": expected an integer, got " + item->dump());
+                return value;
+            }
+            double v = item->get<double>();
+            if (!(v >= static_cast<double>(lo) && v <= static_cast<double>(hi)))
+            {
+                std::ostringstream msg;
+                msg << key << " = " << item->dump() << " " << unit << " is outside [" << lo << ", " << hi << "]";
+                _problem(msg.str());
+                return value;
+            }
+            return item->get<T>();
+        }
+
+        /**
+         * @brief string out of a list of choices
+         *
+         * @param key name of the value
+         * @param fallback default. nullptr makes the key required
+         * @param choices accepted values. Empty accepts any string
+         */
+        std::string choice(const char* key, const char* fallback, const std::vector<std::string>& choices)
+        {
+            std::string value = fallback ? fallback : "";
+            const json* item = _find(key, fallback == nullptr);
+            if (!item) return value;
+            if (!item->is_string())
+            {
+                _problem(std::string(key) + ": expected a string, got " + item->dump());
+                return value;
+            }
+            std::string v = item->get<std::string>();
+            if (choices.empty()) return v;
+            for (const std::string& c : choices)
+                if (v == c) return v;
+            std::string list;
+            for (const std::string& c : choices) list += (list.empty() ? "" : ", ") + c;
+            _problem(std::string(key) + " = \"" + v + "\" is not one of " + list);
+            return value;
+        }
+
+        /**
+         * @brief boolean
+         */
+        bool flag(const char* key, bool fallback)
+        {
+            const json* item = _find(key, false);
+            if (!item) return fallback;
+            if (!item->is_boolean())
+            {
+                _problem(std::string(key) + ": expected true or false, got " + item->dump());
+                return fallback;
+            }
+            return item->get<bool>();
+        }
+
+        /**
+         * @brief raw json value, for structured entries
+         *
+         * @param key name of the value
+         * @param required report the key if it is missing
+         *
+         * @returns the value, nullptr if missing
+         */
+        const json* raw(const char* key, bool required)
+        {
+            return _find(key, required);
+        }
+
+        /**
+         * @brief report the keys that were never read
+         */
+        void check_unknown()
+        {
+            if (!_data) return;
+            for (auto it = _data->begin(); it != _data->end(); ++it)
+                if (!_read.count(it.key()))
+                    _problem("unknown key " + it.key());
+        }
+
+    private:
+        std::string _section;
+        std::vector<std::string>& _problems;
+        const json* _data = nullptr;
+        std::set<std::string> _read;
+
+        void _problem(const std::string& message)
+        {
+            _problems.push_back(_section + ": " + message);
+        }
+
+        const json* _find(const char* key, bool required)
+        {
+            _read.insert(key);
+            if (!_data) return nullptr;
+            auto it = _data->find(key);
+            if (it == _data->end())
+            {
+                if (required) _problem(std::string("missing required key ") + key);
+                return nullptr;
+            }
+            return &*it;
+        }
+};
+
+/**
+ * @brief field of the parameters addressed by a sweep name
+ *
+ * @returns pointer to the field, nullptr if the name is not sweepable
+ */
+static float* _sweep_target(Simulation_params& p, const std::string& name)
+{
+    if (name == "detector.Nd") return &p.detector.Nd;
+    if (name == "detector.width") return &p.detector.width;
+    if (name == "detector.length") return &p.detector.length;
+    if (name == "detector.V_bi") return &p.detector.V_bi;
+    if (name == "detector.V_bias") return &p.detector.V_bias;
+    if (name == "detector.R") return &p.detector.R;
+    if (name == "detector.C") return &p.detector.C;
+    if (name == "detector.electrode_width") return &p.detector.electrode_width;
+    if (name == "detector.e_lifetime") return &p.detector.e_lifetime;
+    if (name == "detector.h_lifetime") return &p.detector.h_lifetime;
+    if (name == "detector.fluence") return &p.detector.fluence;
+    if (name == "detector.beta_e") return &p.detector.beta_e;
+    if (name == "detector.beta_h") return &p.detector.beta_h;
+    if (name == "injection.focus") return &p.injection.focus;
+    if (name == "injection.wavelength") return &p.injection.wavelength;
+    if (name == "injection.NA") return &p.injection.NA;
+    if (name == "injection.refractive_index") return &p.injection.refractive_index;
+    if (name == "injection.importance_fraction") return &p.injection.importance_fraction;
+    if (name == "simulation.dt") return &p.simulation.dt;
+    if (name == "simulation.t_pc") return &p.simulation.t_pc;
+    if (name == "electronics.shaping_time") return &p.electronics.shaping_time;
+    if (name == "electronics.gain") return &p.electronics.gain;
+    return nullptr;
+}
+
+/**
+ * @brief check whether a parameter can be swept
+ *
+ * @param name parameter as "section.key"
+ *
+ * @returns true for the float parameters of the detector, injection,
+ *          simulation and electronics sections
+ */
+bool is_sweepable(const std::string& name)
+{
+    Simulation_params p;
+    return _sweep_target(p, name) != nullptr;
+}
+
+/**
+ * @brief set one parameter
+ *
+ * @param p parameters
+ * @param name parameter as "section.key"
+ * @param value new value
+ *
+ * @throws std::invalid_argument if the parameter is not sweepable
+ */
+void set_parameter(Simulation_params& p, const std::string& name, float value)
+{
+    float* target = _sweep_target(p, name);
+    if (!target) throw std::invalid_argument("set_parameter: " + name + " is not sweepable");
+    *target = value;
+}
+
+/**
+ * @brief parse the sweeps section
+ *
+ * every axis is either a list of values or an arithmetic grid given by
+ * start, step and n. Each value is validated by checking the configuration
+ * with that value in place of the base one
+ */
+static void _parse_sweeps(const json& data, Sweep_params& s, std::vector<std::string>& problems)
+{
+    std::size_t n_problems = problems.size();
+    Section_reader sw(data, "sweeps", problems);
+    s.combine = sw.choice("combine", "product", {"product", "zip"});
+    s.output = sw.choice("output", "sweep.csv", {});
+    const json* axes = sw.raw("axes", true);
+    sw.check_unknown();
+    if (!axes) return;
+    if (!axes->is_array() || axes->empty())
+    {
+        problems.push_back("sweeps: axes must be a non-empty list");
+        return;
+    }
+
+    for (std::size_t a = 0; a < axes->size(); ++a)
+    {
+        const json& axis = (*axes)[a];
+        std::string where = "sweeps: axis " + std::to_string(a);
+        Sweep_axis ax;
+        if (!axis.is_object() || !axis.contains("parameter") || !axis["parameter"].is_string())
+        {
+            problems.push_back(where + ": needs a parameter name");
+            continue;
+        }
+        ax.parameter = axis["parameter"].get<std::string>();
+        if (!is_sweepable(ax.parameter))
+            problems.push_back(where + ": " + ax.parameter + " is not sweepable");
+        if (axis.contains("values") && axis["values"].is_array())
+        {
+            for (const json& v : axis["values"])
+                if (v.is_number()) ax.values.push_back(v.get<float>());
+                else problems.push_back(where + ": values must be numbers");
+        }
+        else if (axis.contains("start") && axis.contains("step") && axis.contains("n") &&
+                 axis["start"].is_number() && axis["step"].is_number() && axis["n"].is_number_integer())
+        {
+            double start = axis["start"].get<double>(), step = axis["step"].get<double>();
+            for (int i = 0; i < axis["n"].get<int>(); ++i)
+                ax.values.push_back(start + i*step);
+        }
+        else
+            problems.push_back(where + ": needs values or start, step and n");
+        if (ax.values.empty())
+            problems.push_back(where + ": no values");
+        s.axes.push_back(ax);
+    }
+    if (s.combine == "zip")
+        for (const Sweep_axis& ax : s.axes)
+            if (ax.values.size() != s.axes.front().values.size())
+                problems.push_back("sweeps: zipped axes must have the same length");
+    if (problems.size() != n_problems) return;
+
+    // every value must pass the checks of the value it replaces, as the
+    // single-point run the sweep is made of
+    json base = data;
+    base.erase("sweeps");
+    base["simulation"]["type"] = "z_scan";
+    for (const Sweep_axis& ax : s.axes)
+    {
+        std::string section = ax.parameter.substr(0, ax.parameter.find('.'));
+        std::string key = ax.parameter.substr(ax.parameter.find('.') + 1);
+        for (float v : ax.values)
+        {
+            json patched = base;
+            patched[section][key] = v;
+            try {
+                parse_simulation_params(patched);
+            }
+            catch (const Config_error& e) {
+                std::ostringstream at;
+                at << "sweeps: " << ax.parameter << " = " << v << ": ";
+                for (const std::string& p : e.get_problems()) problems.push_back(at.str() + p);
+            }
+        }
+    }
+}
+
+/**
+ * @brief parse and validate a configuration
+ *
+ * reads the detector, injection, simulation and (optional) beam_profile and
+ * electronics sections into typed fields, fills the defaults and checks ranges (SI
+ * units) and the consistency between values
+ *
+ * @param data parsed configuration file
+ *
+ * @returns the simulation parameters
+ *
+ * @throws Config_error listing every problem found
+ */
+Simulation_params parse_simulation_params(const json& data)
+{
+    Simulation_params p;
+    std::vector<std::string> problems;
+    const float inf = std::numeric_limits<float>::infinity();
+
+    Section_reader det(data, "detector", problems);
+    Detector_params& d = p.detector;
+    d.Nd = det.number<float>("Nd", nullptr, 1e16, 1e26, "1/m^3");
+    d.width = det.number<float>("width", nullptr, 1e-7, 1e-2, "m");
+    d.length = det.number<float>("length", nullptr, 1e-7, 1e-2, "m");
+    d.V_bi = det.number<float>("V_bi", nullptr, 0., 10., "V");
+    d.V_bias = det.number<float>("V_bias", nullptr, 1e-3, 1e5, "V");
+    d.R = det.number<float>("R", nullptr, 1e-3, 1e9, "Ohm");
+    d.C = det.number<float>("C", &DEFAULT_CAPACITANCE, 1e-16, 1e-6, "F");
+    d.electrode_width = det.number<float>("electrode_width", &d.length, 1e-7, 1e-2, "m");
+    d.material = det.choice("material", nullptr, material_names());
+    d.field_model = det.choice("field_model", "linear", {"linear", "poisson"});
+    d.geometry = det.choice("geometry", "planar", {"planar", "axisymmetric"});
+    const float zero = 0.;
+    d.e_lifetime = det.number<float>("e_lifetime", &zero, 0., 1., "s");
+    d.h_lifetime = det.number<float>("h_lifetime", &zero, 0., 1., "s");
+    d.fluence = det.number<float>("fluence", &zero, 0., 1e22, "1/m^2");
+    d.beta_e = det.number<float>("beta_e", &zero, 0., 1e-6, "m^2/s");
+    d.beta_h = det.number<float>("beta_h", &zero, 0., 1e-6, "m^2/s");
+    det.check_unknown();
+
+    Section_reader inj(data, "injection", problems);
+    Injection_params& i = p.injection;
+    i.focus = inj.number<float>("focus", nullptr, -1e-2, 1e-2, "m");
+    i.wavelength = inj.number<float>("wavelength", nullptr, 100e-9, 20e-6, "m");
+    i.NA = inj.number<float>("NA", nullptr, 1e-3, 1.5, "");
+    i.refractive_index = inj.number<float>("refractive_index", nullptr, 1., 6., "");
+    i.N = inj.number<int>("N", nullptr, 1, 1000000000, "carriers");
+    i.importance_fraction = inj.number<float>("importance_fraction", &zero, 0., 0.999, "");
+    inj.check_unknown();
+
+    Beam_profile_params& b = p.beam_profile;
+    b.z_min = 0.;
+    b.z_max = 0.;
+    b.r_max = 0.;
+    b.squared = false;
+    if (data.contains("beam_profile"))
+    {
+        Section_reader bp(data, "beam_profile", problems);
+        b.file = bp.choice("file", nullptr, {});
+        b.z_min = bp.number<float>("z_min", nullptr, -1e-2, 1e-2, "m");
+        b.z_max = bp.number<float>("z_max", nullptr, -1e-2, 1e-2, "m");
+        b.r_max = bp.number<float>("r_max", &zero, 0., 1e-2, "m");
+        b.squared = bp.flag("squared", false);
+        bp.check_unknown();
+    }
+
+    Section_reader sim(data, "simulation", problems);
+    Run_params& r = p.simulation;
+    const int zero_threads = 0;
+    const bool diffusion = true;
+    const std::uint64_t zero_seed = 0;
+    r.steps = sim.number<int>("steps", nullptr, 1, 100000000, "");
+    r.dt = sim.number<float>("dt", nullptr, 1e-16, 1e-6, "s");
+    r.t_pc = sim.number<float>("t_pc", nullptr, 0., inf, "s");
+    r.type = sim.choice("type", nullptr, {"visualization", "z_scan", "sweep"});
+    r.engine = sim.choice("engine", "stepped", {"stepped", "analytic"});
+    r.diffusion = sim.flag("diffusion", diffusion);
+    r.trapping = sim.flag("trapping", false);
+    r.threads = sim.number<int>("threads", &zero_threads, 0, 4096, "");
+    r.seed = sim.number<std::uint64_t>("seed", &zero_seed, 0, std::numeric_limits<std::uint64_t>::max(), "");
+    r.waveforms = sim.flag("waveforms", false);
+    sim.check_unknown();
+
+    Electronics_params& e = p.electronics;
+    const int order = 1;
+    const float shaping_time = 1e-9;
+    const float gain = 1.;
+    e.model = "rc";
+    e.order = order;
+    e.shaping_time = shaping_time;
+    e.gain = gain;
+    if (data.contains("electronics"))
+    {
+        Section_reader el(data, "electronics", problems);
+        e.model = el.choice("model", "rc", {"rc", "shaper", "measured"});
+        e.order = el.number<int>("order", &order, 0, 10, "");
+        e.shaping_time = el.number<float>("shaping_time", &shaping_time, 1e-13, 1e-5, "s");
+        e.gain = el.number<float>("gain", &gain, 1e-6, 1e9, "");
+        e.response_file = el.choice("response_file", "", {});
+        el.check_unknown();
+        if (e.model == "measured" && e.response_file.empty())
+            problems.push_back("electronics: model measured needs a response_file");
+    }
+
+    // consistency between values, only meaningful once the values are valid
+    if (problems.empty())
+    {
+        if (d.electrode_width > d.length)
+            problems.push_back("detector: electrode_width is larger than length");
+        if (i.NA >= i.refractive_index)
+            problems.push_back("injection: NA must be smaller than refractive_index");
+        if (!b.file.empty() && b.z_min >= b.z_max)
+            problems.push_back("beam_profile: z_min must be smaller than z_max");
+        if (!b.file.empty() && i.importance_fraction > 0.)
+            problems.push_back("injection: importance_fraction needs the analytic beam (no beam_profile)");
+        if (r.t_pc >= r.steps*r.dt)
+            problems.push_back("simulation: t_pc is past the end of the simulated window (steps*dt)");
+        if (r.trapping && d.fluence > 0. && d.beta_e == 0. && d.beta_h == 0.)
+            problems.push_back("detector: fluence needs the trapping constants beta_e and beta_h");
+        if (r.engine == "analytic" && d.electrode_width < d.length)
+            problems.push_back("simulation: the analytic engine needs a pad electrode (electrode_width = length)");
+        if (r.engine == "analytic" && r.diffusion)
+            problems.push_back("simulation: the analytic engine does not diffuse the carriers (set diffusion to false)");
+    }
+
+    if (data.contains("sweeps"))
+        _parse_sweeps(data, p.sweeps, problems);
+    else
+    {
+        p.sweeps.combine = "product";
+        p.sweeps.output = "sweep.csv";
+    }
+    if (r.type == "sweep" && p.sweeps.axes.empty() && problems.empty())
+        problems.push_back("simulation: type sweep needs a sweeps section");
+
+    if (!problems.empty())
+        throw Config_error(problems);
+    return p;
+}
+
+/**
+ * @brief write parameters back as json
+ *
+ * same layout as the configuration file, with every default filled in. Used
+ * to record in the output files what a run was made with
+ *
+ * @param p parameters
+ *
+ * @returns json object with the detector, injection, simulation and
+ *          electronics sections, and beam_profile if a table is used
+ */
+json to_json(const Simulation_params& p)
+{
+    const Detector_params& d = p.detector;
+    const Injection_params& i = p.injection;
+    const Run_params& r = p.simulation;
+    json data;
+    data["detector"] = {{"Nd", d.Nd}, {"width", d.width}, {"length", d.length}, {"V_bi", d.V_bi},
+                        {"V_bias", d.V_bias}, {"R", d.R}, {"C", d.C}, {"electrode_width", d.electrode_width},
+                        {"material", d.material}, {"field_model", d.field_model}, {"geometry", d.geometry},
+                        {"e_lifetime", d.e_lifetime}, {"h_lifetime", d.h_lifetime}, {"fluence", d.fluence},
+                        {"beta_e", d.beta_e}, {"beta_h", d.beta_h}};
+    data["injection"] = {{"focus", i.focus}, {"wavelength", i.wavelength}, {"NA", i.NA},
+                         {"refractive_index", i.refractive_index}, {"N", i.N},
+                         {"importance_fraction", i.importance_fraction}};
+    const Beam_profile_params& b = p.beam_profile;
+    if (!b.file.empty())
+        data["beam_profile"] = {{"file", b.file}, {"z_min", b.z_min}, {"z_max", b.z_max},
+                                {"r_max", b.r_max}, {"squared", b.squared}};
+    data["simulation"] = {{"steps", r.steps}, {"dt", r.dt}, {"t_pc", r.t_pc}, {"type", r.type},
+                          {"engine", r.engine}, {"diffusion", r.diffusion}, {"trapping", r.trapping},
+                          {"threads", r.threads},
+                          {"seed", r.seed}, {"waveforms", r.waveforms}};
+    const Electronics_params& e = p.electronics;
+    data["electronics"] = {{"model", e.model}, {"order", e.order}, {"shaping_time", e.shaping_time},
+                           {"gain", e.gain}, {"response_file", e.response_file}};
+    return data;
+}
+
+/**
+ * @brief build the detector described by the parameters
+ *
+ * @param d detector section
+ *
+ * @returns the detector
+ */
+Detector make_detector(const Detector_params& d)
+{
+    Detector det(d.Nd, d.width, d.length, d.V_bi, d.V_bias, d.R, d.material);
+    det.set_electrode_width(d.electrode_width);
+    det.set_capacitance(d.C);
+    det.set_field_model(d.field_model);
+    det.set_geometry(d.geometry);
+    if (d.e_lifetime > 0.) det.set_e_lifetime(d.e_lifetime);
+    if (d.h_lifetime > 0.) det.set_h_lifetime(d.h_lifetime);
+    det.set_fluence(d.fluence);
+    det.set_e_trapping_constant(d.beta_e);
+    det.set_h_trapping_constant(d.beta_h);
+    return det;
+}
@@ -0,0 +1,302 @@
+#include "sweep.hh"
+#include "beam_profile.hh"
+#include "beam_template.hh"
+#include "detector.hh"
+#include "electronics.hh"
+#include "profiler.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+// consecutive points read out together
+static constexpr std::size_t READOUT_BATCH = 32;
+
+/**
+ * @brief list the points of a sweep
+ *
+ * combines the axes of the sweeps section as a Cartesian product (last axis
+ * fastest) or zipped, and applies the values of each point to a copy of the
+ * base parameters
+ *
+ * @param base parameters shared by all the points
+ *
+ * @returns points of the sweep, without pulses
+ */
+std::vector<Sweep_point> make_sweep_points(const Simulation_params& base)
+{
+    const std::vector<Sweep_axis>& axes = base.sweeps.axes;
+    std::vector<Sweep_point> points;
+    if (axes.empty()) return points;
+
+    std::size_t n_points = 1;
+    if (base.sweeps.combine == "zip")
+        n_points = axes.front().values.size();
+    else
+        for (const Sweep_axis& ax : axes) n_points *= ax.values.size();
+
+    points.resize(n_points);
+    for (std::size_t i = 0; i < n_points; ++i)
+    {
+        Sweep_point& pt = points[i];
+        pt.params = base;
+        std::size_t rest = i;
+        pt.values.resize(axes.size());
+        for (std::size_t a = axes.size(); a-- > 0;)
+        {
+            std::size_t k = i;
+            if (base.sweeps.combine != "zip")
+            {
+                k = rest % axes[a].values.size();
+                rest /= axes[a].values.size();
+            }
+            pt.values[a] = axes[a].values[k];
+            set_parameter(pt.params, axes[a].parameter, pt.values[a]);
+        }
+    }
+    return points;
+}
+
+/**
+ * @brief list the points of the built-in z-scan
+ *
+ * a sweep of the focus over 50 depths from -20 um in steps of 1.8 um, with
+ * the other parameters as given. The points carry no axis values: the focus
+ * of each one is that of its pulse
+ *
+ * @param base parameters shared by all the points
+ *
+ * @returns points of the scan, without pulses
+ */
+std::vector<Sweep_point> make_z_scan_points(const Simulation_params& base)
+{
+    std::vector<float> z_array(50);
+    for(int i = 0; i < 50; ++i)
+        z_array[i] = -20.e-6 + i*90.e-6/50;
+
+    Simulation_params scan = base;
+    scan.sweeps.combine = "product";
+    scan.sweeps.axes = {Sweep_axis{"injection.focus", z_array}};
+    std::vector<Sweep_point> points = make_sweep_points(scan);
+    for (Sweep_point& pt : points) pt.values.clear();
+    return points;
+}
+
+/**
+ * @brief key of the parameters that reach the transport
+ *
+ * everything but the readout (R and t_pc). Floats are written in hex so
+ * equal keys mean bit-identical parameters
+ */
+static std::string _transport_key(const Simulation_params& p)
+{
+    const Detector_params& d = p.detector;
+    const Injection_params& i = p.injection;
+    const Run_params& r = p.simulation;
+    std::ostringstream key;
+    key << std::hexfloat;
+    for (float v : {d.Nd, d.width, d.length, d.V_bi, d.V_bias, d.electrode_width,
+                    d.e_lifetime, d.h_lifetime, d.fluence, d.beta_e, d.beta_h,
+                    i.focus, i.wavelength, i.NA, i.refractive_index, i.importance_fraction, r.dt})
+        key << v << ' ';
+    key << d.material << ' ' << d.field_model << ' ' << d.geometry << ' ' << i.N << ' ' << r.steps << ' '
+        << r.engine << ' ' << r.diffusion << ' ' << r.trapping << ' ' << r.seed;
+    const Beam_profile_params& b = p.beam_profile;
+    key << ' ' << b.file << ' ' << b.z_min << ' ' << b.z_max << ' ' << b.r_max << ' ' << b.squared;
+    return key.str();
+}
+
+/**
+ * @brief key of the parameters that determine the sampled beam
+ */
+static std::string _beam_key(const Simulation_params& p)
+{
+    const Injection_params& i = p.injection;
+    std::ostringstream key;
+    const Beam_profile_params& b = p.beam_profile;
+    key << std::hexfloat << i.wavelength << ' ' << i.NA << ' ' << i.refractive_index << ' '
+        << i.N << ' ' << p.simulation.seed << ' ' << p.detector.geometry << ' ' << b.file << ' ' << b.z_min << ' ' << b.z_max << ' '
+        << b.r_max << ' ' << b.squared;
+    return key.str();
+}
+
+/**
+ * @brief free the waveforms of a pulse, keeping its figures of merit
+ */
+static void _release_waveforms(Pulse& pulse)
+{
+    std::vector<float>().swap(pulse.signal_e);
+    std::vector<float>().swap(pulse.signal_h);
+    std::vector<float>().swap(pulse.signal_total);
+    std::vector<float>().swap(pulse.filtered);
+}
+
+/**
+ * @brief simulate the pulses of a sweep
+ *
+ * groups the points by transport key and runs one transport per group on the
+ * pool. Group g uses the seed derive_seed(seed, g), with a beam template (as
+ * a z-scan does, sampled from the beam profile if there is one) or, with
+ * importance sampling, for the injection sampled at its focus. Each point
+ * then gets the readout of its own R and t_pc, applied in batches of
+ * consecutive points
+ *
+ * with a sink, every point is handed to it in point order as soon as its
+ * pulse is ready and its waveforms are released afterwards (charge and WPC
+ * are kept). Only a few transports then run ahead of the sink and a raw
+ * current is dropped once its last point is done, so the memory does not
+ * grow with the number of points
+ *
+ * if a transport, the readout or the sink throws, the transports already
+ * queued (which read the points) are waited for before the exception leaves
+ *
+ * @param points points of the sweep (see make_sweep_points). Their pulses
+ *               are filled
+ * @param pool threads that run the transports
+ * @param sink called with every point in order. May be empty
+ */
+void run_sweep(std::vector<Sweep_point>& points, Thread_pool& pool, const Sweep_sink& sink)
+{
+    std::map<std::string, std::size_t> group_of_key;
+    std::vector<std::size_t> group(points.size());
+    std::vector<std::size_t> first_point;
+    std::vector<std::size_t> remaining;
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        auto it = group_of_key.emplace(_transport_key(points[i].params), first_point.size());
+        if (it.second)
+        {
+            first_point.push_back(i);
+            remaining.push_back(0);
+        }
+        group[i] = it.first->second;
+        ++remaining[group[i]];
+    }
+
+    // beams are shared by every group with the same beam parameters
+    std::map<std::string, std::shared_ptr<const Beam_template>> beams;
+    for (std::size_t i : first_point)
+    {
+        const Simulation_params& p = points[i].params;
+        if (p.injection.importance_fraction > 0.) continue;
+        std::string key = _beam_key(p);
+        if (beams.count(key)) continue;
+        if (std::shared_ptr<const Beam_profile> profile = beam_profile(p))
+            beams[key] = std::make_shared<Beam_template>(*profile, p.injection.N, p.simulation.seed);
+        else
+            beams[key] = std::make_shared<Beam_template>(p.injection.wavelength,
+                                                         p.injection.NA,
+                                                         p.injection.refractive_index,
+                                                         p.injection.N,
+                                                         p.simulation.seed,
+                                                         -std::numeric_limits<float>::infinity(),
+                                                         std::numeric_limits<float>::infinity(),
+                                                         p.detector.geometry == "axisymmetric");
+    }
+
+    // responses are built before any transport runs, so a response file that
+    // cannot be read fails the sweep straight away
+    std::vector<std::shared_ptr<const Electronics_response>> responses(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i)
+        responses[i] = electronics_response(points[i].params);
+
+    std::size_t n_groups = first_point.size();
+    std::vector<std::future<Pulse>> transports(n_groups);
+    auto submit = [&](std::size_t g)
+    {
+        const Simulation_params* p = &points[first_point[g]].params;
+        std::shared_ptr<const Beam_template> beam;
+        if (p->injection.importance_fraction == 0.)
+            beam = beams.at(_beam_key(*p));
+        std::uint64_t seed = derive_seed(p->simulation.seed, g);
+        transports[g] = pool.submit([p, beam, seed]() {
+            Detector det = make_detector(p->detector);
+            if (beam)
+                return simulate_pulse(*beam, p->injection.focus, *p, &det, seed);
+            return simulate_pulse(p->injection.focus, *p, &det, seed);
+        });
+    };
+
+    // groups are numbered in order of first use. With a sink only window
+    // transports are queued past the group of the current point
+    std::size_t window = sink ? 2*static_cast<std::size_t>(pool.get_n_workers()) + READOUT_BATCH : n_groups;
+    std::size_t n_submitted = 0;
+    std::vector<Pulse> raw(n_groups);
+    std::vector<bool> done(n_groups, false);
+    try {
+        for (std::size_t begin = 0; begin < points.size(); begin += READOUT_BATCH)
+        {
+            std::size_t end = std::min(points.size(), begin + READOUT_BATCH);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::size_t g = group[i];
+                while (n_submitted < n_groups && n_submitted <= g + window)
+                    submit(n_submitted++);
+                if (!done[g])
+                {
+                    raw[g] = transports[g].get();
+                    done[g] = true;
+                }
+                if (--remaining[g] == 0)
+                    points[i].pulse = std::move(raw[g]);
+                else
+                    points[i].pulse = raw[g];
+            }
+
+            // the points of a batch that share a response, dt and t_pc are read
+            // out together
+            std::map<std::tuple<const Electronics_response*, float, float>, std::vector<Pulse*>> batches;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const Simulation_params& p = points[i].params;
+                batches[{responses[i].get(), p.simulation.dt, p.simulation.t_pc}].push_back(&points[i].pulse);
+            }
+            for (auto& batch : batches)
+                apply_readout(batch.second, *std::get<0>(batch.first), std::get<1>(batch.first), std::get<2>(batch.first));
+
+            if (sink)
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    sink(points[i]);
+                    _release_waveforms(points[i].pulse);
+                }
+        }
+    }
+    catch (...) {
+        for (std::future<Pulse>& t : transports)
+            if (t.valid()) t.wait();
+        throw;
+    }
+}
+
+/**
+ * @brief write the results of a sweep as a table
+ *
+ * one line per point: the value of every axis, the collected charge and the
+ * WPC, comma separated with a header line
+ *
+ * @param path output file
+ * @param sweeps sweeps section (axis names)
+ * @param points simulated points
+ */
+void write_sweep_table(const std::string& path, const Sweep_params& sweeps, const std::vector<Sweep_point>& points)
+{
+    TCT_PROFILE_SCOPE("output.csv");
+    std::ofstream out(path);
+    if (!out.is_open()) throw std::runtime_error("Could not open sweep output file: " + path);
+    for (const Sweep_axis& ax : sweeps.axes) out << ax.parameter << ",";
+    out << "charge,WPC\n";
+    out.precision(9);
+    for (const Sweep_point& pt : points)
+    {
+        for (float v : pt.values) out << v << ",";
+        out << pt.pulse.charge << "," << pt.pulse.WPC << "\n";
+    }
+    TCT_PROFILE_COUNT("output.bytes", static_cast<double>(out.tellp()));
+}
@@ -0,0 +1,148 @@
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <exception>
+
+/**
+ * @brief class constructor
+ *
+ * starts the worker threads
+ *
+ * @param n_workers number of threads. 0 or less uses one per hardware thread
+ */
+Thread_pool::Thread_pool(int n_workers)
+{
+    if (n_workers <= 0)
+        n_workers = static_cast<int>(std::thread::hardware_concurrency());
+    if (n_workers <= 0)
+        n_workers = 1;
+
+    _workers.reserve(n_workers);
+    for (int i = 0; i < n_workers; ++i)
+        _workers.emplace_back(&Thread_pool::_worker_loop, this);
+}
+
+/**
+ * @brief class destructor
+ *
+ * lets the workers drain the queue and joins them
+ */
+Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    for (auto& w : _workers)
+        w.join();
+}
+
+/**
+ * @brief body of every worker thread
+ *
+ * pops and runs tasks until the pool is stopped and the queue is empty
+ */
+void Thread_pool::_worker_loop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return _stop || !_tasks.empty(); });
+            if (_stop && _tasks.empty())
+                return;
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+        task();
+    }
+}
+
+
+/**
+ * @brief run f(0), ..., f(n_tasks - 1) on the pool
+ *
+ * tasks are handed out one at a time from a shared counter, so a thread that
+ * finishes early steals the remaining work instead of idling on a fixed
+ * slice. The calling thread also takes tasks, which keeps this safe to call
+ * from inside a pool task (no thread blocks on work nobody has picked up).
+ * Returns once every task has finished. f must write its results to slots
+ * indexed by the task number if the output has to be independent of the
+ * thread count
+ *
+ * @param n_tasks number of tasks
+ * @param f task body, called with the task index
+ *
+ * @throws the first exception thrown by f, once every task has finished or
+ *         been skipped. The tasks not started yet are skipped
+ */
+void Thread_pool::parallel_for(std::size_t n_tasks, const std::function<void(std::size_t)>& f)
+{
+    if (n_tasks == 0)
+        return;
+    if (n_tasks == 1 || _workers.size() <= 1)
+    {
+        for (std::size_t i = 0; i < n_tasks; ++i)
+            f(i);
+        return;
+    }
+
+    // helpers may be dequeued after this call has returned, so they only
+    // hold the shared state and never touch f once all tasks are claimed
+    struct Job
+    {
+        std::function<void(std::size_t)> f;
+        std::size_t n_tasks;
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;   // first exception of f, guarded by mutex
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto job = std::make_shared<Job>();
+    job->f = f;
+    job->n_tasks = n_tasks;
+
+    auto run = [](Job& j)
+    {
+        std::size_t i;
+        while ((i = j.next.fetch_add(1)) < j.n_tasks)
+        {
+            // an exception must not reach the worker loop: it is kept for
+            // the caller, and the task still counts as done
+            if (!j.failed.load())
+            {
+                try {
+                    j.f(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(j.mutex);
+                    if (!j.error) j.error = std::current_exception();
+                    j.failed.store(true);
+                }
+            }
+            if (j.done.fetch_add(1) + 1 == j.n_tasks)
+            {
+                std::lock_guard<std::mutex> lock(j.mutex);
+                j.cv.notify_all();
+            }
+        }
+    };
+
+    std::size_t n_helpers = std::min(_workers.size(), n_tasks - 1);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::size_t h = 0; h < n_helpers; ++h)
+            _tasks.emplace([job, run]() { run(*job); });
+    }
+    _cv.notify_all();
+
+    run(*job);
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cv.wait(lock, [&job] { return job->done.load() == job->n_tasks; });
+    if (job->error)
+        std::rethrow_exception(job->error);
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "transport_engine.hh"
+#include "drift_kernel.hh"
+#include "electric_field.hh"
+#include "profiler.hh"
+#include "weighting_field.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+#define QE 1.602e-19
+
+// carriers per chunk. Multiple of every SIMD width so only the last chunk of
+// each species has a scalar tail
+static constexpr std::size_t CHUNK_SIZE = 4096;
+// steps between two compactions of the active set
+static constexpr int COMPACT_INTERVAL = 16;
+
+/**
+ * @brief class constructor
+ *
+ * @param electrons electron injection. Its carriers are moved in place
+ * @param holes hole injection. Its carriers are moved in place
+ * @param det detector geometry
+ * @param pool threads used to move the carriers. nullptr runs on the caller
+ *
+ * @throws std::logic_error if the electric and weighting field maps are not
+ *         on the same grid
+ */
+Transport_engine::Transport_engine(Charge_injection& electrons, Charge_injection& holes, Detector* det, Thread_pool* pool)
+{
+    _electrons = &electrons;
+    _holes = &holes;
+    _det = det;
+    _pool = pool;
+    _n_steps = 0;
+    _diffusion = false;
+    _trapping = false;
+    _seed = 0;
+    _field = electric_field(det);
+    _weighting = weighting_field(det);
+
+    // the kernel locates each carrier once for both maps. The views are built
+    // once: building one scans the whole map
+    _field_view = _field->view();
+    _weighting_view = _weighting->view();
+    const Field_view& f = _field_view;
+    const Field_view& w = _weighting_view;
+    if (f.x_min != w.x_min || f.y_min != w.y_min || f.inv_dx != w.inv_dx ||
+        f.inv_dy != w.inv_dy || f.nx != w.nx || f.max_j != w.max_j)
+        throw std::logic_error("Transport_engine: electric and weighting fields on different grids");
+}
+
+/**
+ * @brief switch diffusion on or off
+ *
+ * the random numbers of each carrier and step only depend on the seed, the
+ * carrier id and the step number, so the pulse is the same for any number of
+ * threads
+ *
+ * @param diffusion true to add the diffusion random walk
+ * @param seed seed of the random walk
+ */
+void Transport_engine::set_diffusion(bool diffusion, std::uint64_t seed)
+{
+    _diffusion = diffusion;
+    _seed = seed;
+}
+
+/**
+ * @brief switch trapping on or off
+ *
+ * the weight of every carrier decays with the effective trapping time of its
+ * species (Detector::get_e_trapping_time), so trapping adds no noise
+ *
+ * @param trapping true to let the carriers be trapped
+ */
+void Transport_engine::set_trapping(bool trapping)
+{
+    _trapping = trapping;
+}
+
+/**
+ * @brief add up partial sums in a fixed order
+ *
+ * pairwise reduction tree over [begin, end). The order of the additions only
+ * depends on the number of values, never on who computed them
+ *
+ * @returns sum of the values
+ */
+static float _tree_reduce(const float* values, std::size_t begin, std::size_t end)
+{
+    if (end - begin == 0) return 0.;
+    if (end - begin == 1) return values[begin];
+    std::size_t mid = begin + (end - begin)/2;
+    return _tree_reduce(values, begin, mid) + _tree_reduce(values, mid, end);
+}
+
+/**
+ * @brief advance both species one time step
+ *
+ * the kernel constants are built once per species and step, then each carrier
+ * array is traversed exactly once: v(E) lookup, position update and
+ * current accumulation happen in the same pass (see drift_kernel). The
+ * current is the Ramo current in the weighting field of the readout
+ * electrode, i = q*v.E_w.
+ *
+ * electrons and holes are cut in CHUNK_SIZE chunks that are processed on the
+ * pool (or in sequence without one). Chunks are the same for any number of
+ * threads, and so is the reduction of their partial currents. Every
+ * COMPACT_INTERVAL steps the collected carriers are removed
+ *
+ * @param dt time step (s)
+ *
+ * @returns induced current of electrons and holes during this step (A)
+ */
+Step_current Transport_engine::step(float dt)
+{
+    TCT_PROFILE_SCOPE("transport.step");
+    Drift_params p_e = make_drift_params(_det, _electrons->get_velocity_table(), 0, dt);
+    Drift_params p_h = make_drift_params(_det, _holes->get_velocity_table(), 1, dt);
+    for (Drift_params* p : {&p_e, &p_h})
+    {
+        if (!_diffusion) p->sigma = 0.;
+        if (!_trapping) p->decay = 1.;
+        p->key0 = static_cast<std::uint32_t>(_seed);
+        p->key1 = static_cast<std::uint32_t>(_seed >> 32);
+        p->field = _field_view;
+        p->weighting = _weighting_view;
+    }
+    // electrons and holes share their ids, so the species goes in the counter
+    p_e.counter = 2*static_cast<std::uint32_t>(_n_steps);
+    p_h.counter = 2*static_cast<std::uint32_t>(_n_steps) + 1;
+
+    Carrier_store& e = _electrons->get_charges();
+    Carrier_store& h = _holes->get_charges();
+    TCT_PROFILE_COUNT("transport.active_carriers", e.size() + h.size());
+    std::size_t n_chunks_e = (e.size() + CHUNK_SIZE - 1)/CHUNK_SIZE;
+    std::size_t n_chunks_h = (h.size() + CHUNK_SIZE - 1)/CHUNK_SIZE;
+    _partial.assign(n_chunks_e + n_chunks_h, 0.);
+
+    auto run_chunk = [&](std::size_t chunk)
+    {
+        TCT_PROFILE_SCOPE("transport.kernel");
+        bool is_e = chunk < n_chunks_e;
+        Carrier_store& store = is_e ? e : h;
+        std::size_t first = (is_e ? chunk : chunk - n_chunks_e)*CHUNK_SIZE;
+        std::size_t last = std::min(first + CHUNK_SIZE, store.size());
+        _partial[chunk] = drift_kernel(store, first, last, is_e ? p_e : p_h);
+    };
+
+    if (_pool)
+        _pool->parallel_for(_partial.size(), run_chunk);
+    else
+        for (std::size_t chunk = 0; chunk < _partial.size(); ++chunk)
+            run_chunk(chunk);
+
+    float sum_e = _tree_reduce(_partial.data(), 0, n_chunks_e);
+    float sum_h = _tree_reduce(_partial.data(), n_chunks_e, _partial.size());
+
+    // a carrier outside the field region has zero velocity from then on, so
+    // dropping it does not change the current. The first step also removes
+    // the carriers injected outside the depleted region
+    if (_n_steps++ % COMPACT_INTERVAL == 0)
+    {
+        e.compact(-p_e.x_half, p_e.x_half, 0., p_e.y_max);
+        h.compact(-p_h.x_half, p_h.x_half, 0., p_h.y_max);
+    }
+
+    Step_current current;
+    current.e = sum_e * QE;
+    current.h = sum_h * QE;
+    return current;
+}
+
+/**
+ * @brief check whether all charge has been collected
+ *
+ * @returns true once no electron or hole is left in the field region. Every
+ *          later step would return zero current
+ */
+bool Transport_engine::is_done() const
+{
+    return _electrons->get_charges().empty() && _holes->get_charges().empty();
+}
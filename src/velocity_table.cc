@@ -0,0 +1,92 @@
+#include "velocity_table.hh"
+#include "utility.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief class constructor
+ *
+ * resamples a measured v(E) curve on n_points equally spaced fields between 0
+ * and E_max. Fields outside the measured range take the value at the closest
+ * end of the curve, as linear_interpolation does
+ *
+ * @param E_exp electric field of the measured curve (MV/cm)
+ * @param v_exp drift velocity of the measured curve (cm/s)
+ * @param E_max largest field the table has to cover (V/m)
+ * @param n_points number of grid nodes
+ */
+Velocity_table::Velocity_table(std::vector<float> E_exp, std::vector<float> v_exp, float E_max, int n_points)
+{
+    if (E_exp.empty() || E_exp.size() != v_exp.size())
+        throw std::invalid_argument("Velocity_table: empty or mismatched v(E) curve");
+    if (n_points < 2) throw std::invalid_argument("Velocity_table: n_points must be >= 2");
+    if (!(E_max > 0.)) E_max = 1.;
+
+    float dE = E_max/(n_points - 1);
+    _inv_dE = 1./dE;
+    _max_index = n_points - 2;
+
+    _v.resize(n_points);
+    _dv.resize(n_points);
+    for (int i = 0; i < n_points; ++i)
+        _v[i] = linear_interpolation(i*dE/1e8, E_exp, v_exp)*1e-2;
+    for (int i = 0; i < n_points - 1; ++i)
+        _dv[i] = _v[i+1] - _v[i];
+    _dv[n_points - 1] = 0.;
+}
+
+/**
+ * @brief class constructor
+ *
+ * tabulates the Caughey-Thomas drift velocity,
+ * v(E) = mu E / (1 + (mu E/v_sat)^beta)^(1/beta), on n_points equally
+ * spaced fields between 0 and E_max
+ *
+ * @param mobility low field mobility (m^2/Vs)
+ * @param saturation_velocity (m/s)
+ * @param exponent beta
+ * @param E_max largest field the table has to cover (V/m)
+ * @param n_points number of grid nodes
+ */
+Velocity_table::Velocity_table(float mobility, float saturation_velocity, float exponent, float E_max, int n_points)
+{
+    if (!(mobility > 0.) || !(saturation_velocity > 0.) || !(exponent > 0.))
+        throw std::invalid_argument("Velocity_table: mobility parameters must be positive");
+    if (n_points < 2) throw std::invalid_argument("Velocity_table: n_points must be >= 2");
+    if (!(E_max > 0.)) E_max = 1.;
+
+    float dE = E_max/(n_points - 1);
+    _inv_dE = 1./dE;
+    _max_index = n_points - 2;
+
+    _v.resize(n_points);
+    _dv.resize(n_points);
+    for (int i = 0; i < n_points; ++i)
+    {
+        double v_ohmic = mobility*(i*dE);
+        _v[i] = v_ohmic/std::pow(1. + std::pow(v_ohmic/saturation_velocity, exponent), 1./exponent);
+    }
+    for (int i = 0; i < n_points - 1; ++i)
+        _dv[i] = _v[i+1] - _v[i];
+    _dv[n_points - 1] = 0.;
+}
+
+/**
+ * @brief drift velocity at a given field
+ *
+ * scalar version of the lookup done by the drift kernels. Fields above the
+ * grid are clamped to its last node
+ *
+ * @param E electric field (V/m)
+ *
+ * @returns drift velocity (m/s)
+ */
+float Velocity_table::operator()(float E) const
+{
+    float f = std::clamp(E*_inv_dE, 0.f, _max_index + 1.f);
+    float i = std::min(static_cast<float>(static_cast<int>(f)), _max_index);
+    int idx = static_cast<int>(i);
+    return _v[idx] + (f - i)*_dv[idx];
+}
@@ -0,0 +1,180 @@
+#include "waveform_writer.hh"
+#include "profiler.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+static const char* WAVEFORM_NAMES[] = {"signal_e", "signal_h", "signal_total", "filtered"};
+
+/**
+ * @brief class constructor
+ *
+ * creates the directory and the columns and starts the writer thread
+ *
+ * @param dir output directory. Created if missing
+ * @param params base parameters of the run, stored in meta.json
+ * @param axes swept parameters, one column each in the order of Sweep_point::values
+ * @param max_pending pulses queued before append() blocks
+ *
+ * @throws std::runtime_error if a file cannot be created
+ */
+Waveform_writer::Waveform_writer(const std::string& dir, const Simulation_params& params,
+                                 const std::vector<std::string>& axes, std::size_t max_pending)
+{
+    _dir = dir;
+    _steps = static_cast<std::size_t>(params.simulation.steps);
+    _max_pending = max_pending ? max_pending : 1;
+    _bytes = 0;
+    _closing = false;
+    _closed = false;
+
+    std::filesystem::create_directories(dir);
+    _scalar_names = {"focus", "charge", "WPC"};
+    _scalar_names.insert(_scalar_names.end(), axes.begin(), axes.end());
+    for (const std::string& name : _scalar_names)
+        _scalars.emplace_back(new Npy_writer(dir + "/" + name + ".npy", 0));
+    for (const char* name : WAVEFORM_NAMES)
+        _waveforms.emplace_back(new Npy_writer(dir + "/" + name + ".npy", _steps));
+
+    _meta["dt"] = params.simulation.dt;
+    _meta["steps"] = _steps;
+    _meta["axes"] = axes;
+    _meta["scalars"] = _scalar_names;
+    _meta["waveforms"] = std::vector<std::string>(std::begin(WAVEFORM_NAMES), std::end(WAVEFORM_NAMES));
+    _meta["parameters"] = to_json(params);
+    // an interrupted run is recognisable by "complete": false
+    _write_meta(0, false);
+
+    _thread = std::thread(&Waveform_writer::_run, this);
+}
+
+/**
+ * @brief class destructor. Flushes the queue and closes the files
+ */
+Waveform_writer::~Waveform_writer()
+{
+    try {
+        close();
+    }
+    catch (...) {
+    }
+}
+
+/**
+ * @brief queue a pulse for writing
+ *
+ * blocks while max_pending pulses are waiting
+ *
+ * @param point pulse and axis values
+ *
+ * @throws std::invalid_argument if the pulse does not have steps samples or
+ * the wrong number of axis values
+ * @throws whatever stopped the writer thread
+ */
+void Waveform_writer::append(const Sweep_point& point)
+{
+    if (point.values.size() + 3 != _scalar_names.size())
+        throw std::invalid_argument("Waveform_writer::append: wrong number of axis values");
+    const Pulse& p = point.pulse;
+    for (const std::vector<float>* w : {&p.signal_e, &p.signal_h, &p.signal_total, &p.filtered})
+        if (w->size() != _steps)
+            throw std::invalid_argument("Waveform_writer::append: waveform with "
+                                        + std::to_string(w->size()) + " samples, expected "
+                                        + std::to_string(_steps));
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _not_full.wait(lock, [this] {return _queue.size() < _max_pending || _error;});
+    if (_error) std::rethrow_exception(_error);
+    if (_closing) throw std::logic_error("Waveform_writer::append: writer is closed");
+    // only what is written is copied, not the parameter block
+    _queue.emplace_back();
+    _queue.back().values = point.values;
+    _queue.back().pulse = p;
+    _not_empty.notify_one();
+}
+
+/**
+ * @brief write the pending pulses and finish the files
+ *
+ * patches the shapes of the columns and writes the pulse count to meta.json
+ *
+ * @throws whatever stopped the writer thread
+ */
+void Waveform_writer::close()
+{
+    if (_closed) return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closing = true;
+    }
+    _not_empty.notify_one();
+    if (_thread.joinable()) _thread.join();
+    _closed = true;
+    if (_error) std::rethrow_exception(_error);
+
+    for (auto& column : _scalars) {column->close(); _bytes += column->get_bytes_written();}
+    for (auto& column : _waveforms) {column->close(); _bytes += column->get_bytes_written();}
+    _write_meta(_waveforms[0]->get_rows(), true);
+}
+
+/**
+ * @brief writer thread. Drains the queue until closed
+ */
+void Waveform_writer::_run()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this] {return !_queue.empty() || _closing;});
+        if (_queue.empty()) return;
+        Sweep_point point = std::move(_queue.front());
+        _queue.pop_front();
+        lock.unlock();
+        _not_full.notify_one();
+
+        try {
+            _write(point);
+        }
+        catch (...) {
+            lock.lock();
+            _error = std::current_exception();
+            _queue.clear();
+            _not_full.notify_all();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief write one row of every column
+ */
+void Waveform_writer::_write(const Sweep_point& point)
+{
+    TCT_PROFILE_SCOPE("output.waveforms");
+    const Pulse& p = point.pulse;
+    float scalars[3] = {p.focus, p.charge, p.WPC};
+    for (std::size_t i = 0; i < 3; ++i) _scalars[i]->write_row(&scalars[i]);
+    for (std::size_t i = 0; i < point.values.size(); ++i) _scalars[3 + i]->write_row(&point.values[i]);
+
+    _waveforms[0]->write_row(p.signal_e.data());
+    _waveforms[1]->write_row(p.signal_h.data());
+    _waveforms[2]->write_row(p.signal_total.data());
+    _waveforms[3]->write_row(p.filtered.data());
+    TCT_PROFILE_COUNT("output.bytes", (_scalars.size() + 4*_steps)*sizeof(float));
+}
+
+/**
+ * @brief write meta.json
+ *
+ * @param n_pulses rows of every column
+ * @param complete false while the run is in progress
+ */
+void Waveform_writer::_write_meta(std::size_t n_pulses, bool complete)
+{
+    _meta["n_pulses"] = n_pulses;
+    _meta["complete"] = complete;
+    std::ofstream out(_dir + "/meta.json");
+    if (!out.is_open()) throw std::runtime_error("Could not open output file: " + _dir + "/meta.json");
+    out << _meta.dump(4) << "\n";
+}
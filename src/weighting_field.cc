@@ -0,0 +1,145 @@
+#include "weighting_field.hh"
+#include "detector.hh"
+#include "poisson.hh"
+#include "profiler.hh"
+#include "resource_cache.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// nodes of the weighting field grid along each axis (2^k + 1 for multigrid)
+static constexpr int N_NODES = 129;
+// weighting fields kept for reuse
+static constexpr std::size_t CACHE_SIZE = 16;
+
+/**
+ * @brief hash of the geometry that determines the weighting field
+ *
+ * FNV-1a over the bit patterns of depth, length, electrode width and
+ * symmetry
+ */
+static std::uint64_t _geometry_hash(float depth, float length, float electrode_width, bool axisymmetric)
+{
+    std::uint64_t h = 1469598103934665603ULL;
+    for (float v : {depth, length, electrode_width, static_cast<float>(N_NODES), axisymmetric ? 1.f : 0.f})
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        for (int k = 0; k < 4; ++k)
+        {
+            h ^= (bits >> (8*k)) & 0xFF;
+            h *= 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+/**
+ * @brief weighting field from the weighting potential on the nodes
+ *
+ * E_w = -grad(phi): central differences inside, one-sided on the edges
+ */
+static void _gradient(Field_map& map, const std::vector<double>& phi)
+{
+    int nx = map.get_nx(), ny = map.get_ny();
+    double hx = map.get_dx(), hy = map.get_dy();
+    float* ex = map.fx();
+    float* ey = map.fy();
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+        {
+            int i0 = std::max(i - 1, 0), i1 = std::min(i + 1, nx - 1);
+            int j0 = std::max(j - 1, 0), j1 = std::min(j + 1, ny - 1);
+            ex[j*nx + i] = -(phi[j*nx + i1] - phi[j*nx + i0])/((i1 - i0)*hx);
+            ey[j*nx + i] = -(phi[j1*nx + i] - phi[j0*nx + i])/((j1 - j0)*hy);
+        }
+    map.drop_round_off(1e-6);
+}
+
+/**
+ * @brief solve the weighting field of a geometry
+ */
+static std::shared_ptr<const Field_map> _solve(float depth, float length, float electrode_width)
+{
+    TCT_PROFILE_SCOPE("field.weighting");
+    int nx = N_NODES, ny = N_NODES;
+    auto map = std::make_shared<Field_map>(nx, ny, -length/2., length/2., 0., depth);
+    double hx = map->get_dx(), hy = map->get_dy();
+
+    // Dirichlet rows: readout strip at y = 0, back plane at y = depth. The
+    // interior starts from the parallel plate solution 1 - y/depth
+    std::vector<double> phi(static_cast<std::size_t>(nx)*ny, 0.);
+    std::vector<double> rhs(phi.size(), 0.);
+    for (int j = 0; j < ny - 1; ++j)
+        for (int i = 0; i < nx; ++i)
+            phi[j*nx + i] = 1. - static_cast<double>(j)/(ny - 1);
+    for (int i = 0; i < nx; ++i)
+        phi[i] = std::abs(map->get_x(i)) <= electrode_width/2. + 1e-3*hx ? 1. : 0.;
+    solve_poisson(phi, rhs, nx, ny, hx, hy);
+
+    _gradient(*map, phi);
+    return map;
+}
+
+/**
+ * @brief solve the weighting field of a cylindrical sensor
+ *
+ * readout disc of diameter electrode_width centred on the axis of a sensor
+ * of diameter length. The potential is solved on the (r, y) half-plane and
+ * mirrored onto the map, whose x axis then holds the signed radius
+ */
+static std::shared_ptr<const Field_map> _solve_axisymmetric(float depth, float length, float electrode_width)
+{
+    TCT_PROFILE_SCOPE("field.weighting");
+    int nx = N_NODES, ny = N_NODES;
+    auto map = std::make_shared<Field_map>(nx, ny, -length/2., length/2., 0., depth);
+    double hr = map->get_dx(), hy = map->get_dy();
+
+    // node nr - 1 + k of the map is at radius k*hr
+    int nr = (nx + 1)/2;
+    std::vector<double> half(static_cast<std::size_t>(nr)*ny, 0.);
+    std::vector<double> rhs(half.size(), 0.);
+    for (int j = 0; j < ny - 1; ++j)
+        for (int i = 0; i < nr; ++i)
+            half[j*nr + i] = 1. - static_cast<double>(j)/(ny - 1);
+    for (int i = 0; i < nr; ++i)
+        half[i] = i*hr <= electrode_width/2. + 1e-3*hr ? 1. : 0.;
+    solve_poisson_axisymmetric(half, rhs, nr, ny, hr, hy);
+
+    std::vector<double> phi(static_cast<std::size_t>(nx)*ny);
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+            phi[j*nx + i] = half[j*nr + std::abs(i - (nr - 1))];
+    _gradient(*map, phi);
+    return map;
+}
+
+/**
+ * @brief weighting field of the detector
+ *
+ * solves it the first time a geometry is seen and returns the cached map
+ * afterwards (the CACHE_SIZE last used ones are kept). With the axisymmetric geometry the x axis of the map is the
+ * signed radius. Safe to call from several threads
+ *
+ * @param det detector geometry
+ *
+ * @returns weighting field (1/m) over [-L/2, L/2] x [0, depth]
+ */
+std::shared_ptr<const Field_map> weighting_field(Detector* det)
+{
+    static Resource_cache<std::uint64_t, Field_map> cache(CACHE_SIZE);
+
+    float depth = std::min(det->get_depleted_width(), det->get_physical_width());
+    float length = det->get_physical_length();
+    float electrode_width = std::min(det->get_electrode_width(), length);
+    bool axisymmetric = det->get_geometry() == "axisymmetric";
+    std::uint64_t key = _geometry_hash(depth, length, electrode_width, axisymmetric);
+
+    return cache.get(key, [&]() {
+        return axisymmetric ? _solve_axisymmetric(depth, length, electrode_width)
+                            : _solve(depth, length, electrode_width);
+    });
+}
@@ -0,0 +1,102 @@
+/**
+ * @brief Cross-check of the analytic and the stepped transport engines
+ * @author D. Rosich
+ *
+ * Simulates pulses of the default configuration (config.json, linear field,
+ * pad electrode) without diffusion, which the analytic engine leaves out,
+ * with both engines, with and without trapping and for a partially depleted
+ * silicon sensor, and checks that the collected charge and the WPC agree.
+ * Both engines see the same sampled carriers, so the difference is the
+ * discretisation of the stepped transport (its last step overshoots the
+ * electrode).
+ *
+ *   engine_crosscheck <project directory>
+ *
+ * Exits with status 0 if every pulse agrees within the tolerances.
+ */
+
+#include "detector.hh"
+#include "pulse.hh"
+#include "simulation_params.hh"
+#include "thread_pool.hh"
+#include "utility.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <string>
+
+// relative tolerances of the charge and the WPC
+static constexpr double CHARGE_TOLERANCE = 0.01;
+static constexpr double WPC_TOLERANCE = 0.01;
+
+/**
+ * @brief compare both engines at one focus
+ *
+ * @returns true if they agree
+ */
+static bool _check(const Simulation_params& base, float focus, Thread_pool& pool, const char* label)
+{
+    Simulation_params stepped = base;
+    stepped.simulation.engine = "stepped";
+    Simulation_params analytic = base;
+    analytic.simulation.engine = "analytic";
+
+    Detector det = make_detector(base.detector);
+    Pulse s = simulate_pulse(focus, stepped, &det, base.simulation.seed, &pool);
+    Pulse a = simulate_pulse(focus, analytic, &det, base.simulation.seed, &pool);
+
+    double d_charge = std::abs(s.charge - a.charge)/std::abs(a.charge);
+    double d_WPC = std::abs(s.WPC - a.WPC)/std::abs(a.WPC);
+    bool ok = d_charge <= CHARGE_TOLERANCE && d_WPC <= WPC_TOLERANCE;
+    std::printf("%-12s focus %6.1f um  charge %.4e / %.4e (%.2f%%)  WPC %.4e / %.4e (%.2f%%)  %s\n",
+                label, focus*1e6, s.charge, a.charge, 100*d_charge, s.WPC, a.WPC, 100*d_WPC,
+                ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: %s <project directory>\n", argv[0]);
+        return 2;
+    }
+    try {
+        set_project_directory(argv[1]);
+        std::ifstream file(project_directory() + "/config.json");
+        Simulation_params base = parse_simulation_params(nlohmann::json::parse(file));
+        base.simulation.diffusion = false;
+        Thread_pool pool(base.simulation.threads);
+
+        // heavy trapping: about two thirds of the charge is lost
+        Simulation_params trapped = base;
+        trapped.simulation.trapping = true;
+        trapped.detector.fluence = 1e20;
+        trapped.detector.beta_e = 5.6e-11;
+        trapped.detector.beta_h = 7.7e-11;
+
+        // partially depleted silicon: the Caughey-Thomas v(E) vanishes at
+        // the depletion edge. The depleted region is thin, so a finer step
+        // keeps the overshoot of the stepped holes within the tolerance
+        Simulation_params silicon = base;
+        silicon.detector.material = "Si";
+        silicon.detector.V_bias = 10.;
+        silicon.simulation.dt = base.simulation.dt/4.;
+        silicon.simulation.steps = base.simulation.steps*4;
+
+        bool ok = true;
+        for (float focus : {5e-6f, 25e-6f, 45e-6f})
+        {
+            ok = _check(base, focus, pool, "no trapping") && ok;
+            ok = _check(trapped, focus, pool, "trapping") && ok;
+            ok = _check(silicon, focus, pool, "Si 10 V") && ok;
+        }
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "engine_crosscheck: %s\n", e.what());
+        return 2;
+    }
+}